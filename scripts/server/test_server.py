@@ -66,6 +66,36 @@ def single_test_mode(url, src_image_path, loop_times):
     return
 
 
+def binary_test_mode(url, src_image_path, loop_times):
+    """_summary_
+
+    Args:
+        url (_type_): _description_
+        src_image_path (_type_): _description_
+        loop_times (_type_): _description_
+    """
+    assert ops.exists(src_image_path), '{:s} not exist'.format(src_image_path)
+    with open(src_image_path, 'rb') as f:
+        image_data = f.read()
+
+    task_id = src_image_path + str(time.time())
+    m2 = hashlib.md5()
+    m2.update(task_id.encode())
+    task_id = m2.hexdigest()
+    headers = {
+        'Content-Type': 'application/octet-stream',
+        'X-Req-Id': task_id,
+    }
+
+    for i in range(loop_times):
+        try:
+            resp = requests.post(url=url, data=image_data, headers=headers)
+            print(resp.text[:200])
+        except Exception as e:
+            print(e)
+    return
+
+
 def locust_test_mode(url, src_image_path, u, r, t):
     """_summary_
 
@@ -100,8 +130,8 @@ def main_process():
         print(CFG_MAP.keys())
         return
     test_mode = args.mode
-    if test_mode not in ['single', 'locust']:
-        print('Only support \'single\' and \'locust\' mode')
+    if test_mode not in ['single', 'binary', 'locust']:
+        print('Only support \'single\', \'binary\' and \'locust\' mode')
         return
     
     cfg = CFG_MAP[server_name]
@@ -116,6 +146,14 @@ def main_process():
             src_image_path=source_image_path,
             loop_times=loop_times
         )
+    elif test_mode == 'binary':
+        loop_times = cfg.SINGLE.LOOP_TIMES
+        print('Start test server for model: {:s}, mode {:s}'.format(model_name, test_mode))
+        binary_test_mode(
+            url=url,
+            src_image_path=source_image_path,
+            loop_times=loop_times
+        )
     else:
         u = cfg.LOCUST.U
         r = cfg.LOCUST.R
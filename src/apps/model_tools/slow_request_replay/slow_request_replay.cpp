@@ -0,0 +1,267 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: slow_request_replay.cpp
+* Date: 26-10-16
+************************************************/
+// replay slow requests captured by a model server against its model in process
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+#include <toml/toml.hpp>
+
+#include "common/file_path_util.h"
+#include "common/slow_request_sampler.h"
+#include "common/status_code.h"
+#include "common/time_stamp.h"
+#include "factory/server_host_task.h"
+
+using jinq::common::FilePathUtil;
+using jinq::common::SlowRequestSampler;
+using jinq::common::StatusCode;
+using jinq::common::Timestamp;
+using jinq::common::slow_request_record;
+using jinq::models::BaseAiModel;
+using jinq::models::io_define::common_io::mat_input;
+
+namespace classification = jinq::factory::classification;
+namespace enhancement = jinq::factory::enhancement;
+namespace feature_point = jinq::factory::feature_point;
+namespace matting = jinq::factory::matting;
+namespace object_detection = jinq::factory::object_detection;
+namespace ocr = jinq::factory::ocr;
+namespace scene_segmentation = jinq::factory::scene_segmentation;
+namespace io = jinq::models::io_define;
+
+using model_runner = std::function<StatusCode(const mat_input&)>;
+
+/***
+ * init model with its model config and wrap it into a runner which drops model output
+ * @tparam OUTPUT
+ * @param model
+ * @param model_cfg_path
+ * @return empty runner if model init failed
+ */
+template<typename OUTPUT>
+model_runner make_runner(std::unique_ptr<BaseAiModel<mat_input, OUTPUT>> model, const std::string& model_cfg_path) {
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "model config file not exist: " << model_cfg_path;
+        return nullptr;
+    }
+    auto model_cfg = toml::parse(model_cfg_path);
+    if (model->init(model_cfg) != StatusCode::OK || !model->is_successfully_initialized()) {
+        LOG(ERROR) << "model init failed with config: " << model_cfg_path;
+        return nullptr;
+    }
+    std::shared_ptr<BaseAiModel<mat_input, OUTPUT>> shared_model(std::move(model));
+    return [shared_model](const mat_input& input) {
+        OUTPUT output;
+        return shared_model->run(input, output);
+    };
+}
+
+/***
+ * create model of server section the same way its server creates workers
+ * @param config
+ * @param server_section_name
+ * @return empty runner if no model server uses this section name
+ */
+model_runner create_model_runner(const decltype(toml::parse(""))& config, const std::string& server_section_name) {
+    using runner_creator = std::function<model_runner(const std::string&)>;
+    // server section -> (section holding model_config_file_path, runner creator)
+    static const std::map<std::string, std::pair<std::string, runner_creator> > creators = {
+        {"DENSENET_CLASSIFICATION_SERVER", {"DENSENET", [](const std::string& path) {
+            return make_runner(classification::create_densenet_classifier<mat_input, io::classification::std_classification_output>("replay"), path);
+        }}},
+        {"MOBILENETV2_CLASSIFICATION_SERVER", {"MOBILENETV2", [](const std::string& path) {
+            return make_runner(classification::create_mobilenetv2_classifier<mat_input, io::classification::std_classification_output>("replay"), path);
+        }}},
+        {"RESNET_CLASSIFICATION_SERVER", {"RESNET", [](const std::string& path) {
+            return make_runner(classification::create_resnet_classifier<mat_input, io::classification::std_classification_output>("replay"), path);
+        }}},
+        {"ATTENTIVE_GAN_DERAIN_SERVER", {"ATTENTIVE_GAN_DERAIN", [](const std::string& path) {
+            return make_runner(enhancement::create_attentivegan_enhancementor<mat_input, io::enhancement::std_enhancement_output>("replay"), path);
+        }}},
+        {"ENLIGHTEN_GAN_SERVER", {"ENLIGHTEN_GAN", [](const std::string& path) {
+            return make_runner(enhancement::create_enlightengan_enhancementor<mat_input, io::enhancement::std_enhancement_output>("replay"), path);
+        }}},
+        {"REAL_ESRGAN_SERVER", {"REAL_ESRGAN_SERVER", [](const std::string& path) {
+            return make_runner(enhancement::create_realesrgan_enhancementor<mat_input, io::enhancement::std_enhancement_output>("replay"), path);
+        }}},
+        {"SUPERPOINT_FP_SERVER", {"SUPERPOINT", [](const std::string& path) {
+            return make_runner(feature_point::create_superpoint_extractor<mat_input, io::feature_point::std_feature_point_output>("replay"), path);
+        }}},
+        {"MODNET_SERVER", {"MODNET", [](const std::string& path) {
+            return make_runner(matting::create_modnet_segmentor<mat_input, io::matting::std_matting_output>("replay"), path);
+        }}},
+        {"PP_MATTING_SERVER", {"PP_MATTING", [](const std::string& path) {
+            return make_runner(matting::create_ppmatting_segmentor<mat_input, io::matting::std_matting_output>("replay"), path);
+        }}},
+        {"LIBFACE_DETECTION_SERVER", {"LIBFACE", [](const std::string& path) {
+            return make_runner(object_detection::create_libface_detector<mat_input, io::object_detection::std_face_detection_output>("replay"), path);
+        }}},
+        {"NANODET_DETECTION_SERVER", {"NANODET", [](const std::string& path) {
+            return make_runner(object_detection::create_nanodet_detector<mat_input, io::object_detection::std_object_detection_output>("replay"), path);
+        }}},
+        {"YOLOV5_DETECTION_SERVER", {"YOLOV5", [](const std::string& path) {
+            return make_runner(object_detection::create_yolov5_detector<mat_input, io::object_detection::std_object_detection_output>("replay"), path);
+        }}},
+        {"YOLOV6_DETECTION_SERVER", {"YOLOV6", [](const std::string& path) {
+            return make_runner(object_detection::create_yolov6_detector<mat_input, io::object_detection::std_object_detection_output>("replay"), path);
+        }}},
+        {"YOLOV7_DETECTION_SERVER", {"YOLOV7", [](const std::string& path) {
+            return make_runner(object_detection::create_yolov7_detector<mat_input, io::object_detection::std_object_detection_output>("replay"), path);
+        }}},
+        {"DBNET_SERVER", {"DBNET", [](const std::string& path) {
+            return make_runner(ocr::create_dbtext_detector<mat_input, io::ocr::std_text_regions_output>("replay"), path);
+        }}},
+        {"BISENETV2_SERVER", {"BISENETV2", [](const std::string& path) {
+            return make_runner(scene_segmentation::create_bisenetv2_segmentor<mat_input, io::scene_segmentation::std_scene_segmentation_output>("replay"), path);
+        }}},
+        {"PPHUMAN_SEG_SERVER", {"PPHUMAN_SEG", [](const std::string& path) {
+            return make_runner(scene_segmentation::create_pphuman_segmentor<mat_input, io::scene_segmentation::std_scene_segmentation_output>("replay"), path);
+        }}},
+    };
+
+    auto creator = creators.find(server_section_name);
+    if (creator == creators.end()) {
+        LOG(ERROR) << "No server uses section named: " << server_section_name;
+        return nullptr;
+    }
+    const auto& model_section_name = creator->second.first;
+    if (!config.contains(model_section_name) || !config.at(model_section_name).contains("model_config_file_path")) {
+        LOG(ERROR) << "missing model_config_file_path in section: " << model_section_name;
+        return nullptr;
+    }
+    return creator->second.second(config.at(model_section_name).at("model_config_file_path").as_string());
+}
+
+/***
+ * find server section of the server which captured requests by its server url
+ * @param config
+ * @param server_uri
+ * @return empty if not found
+ */
+std::string find_server_section(const decltype(toml::parse(""))& config, const std::string& server_uri) {
+    for (const auto& section : config.as_table()) {
+        if (section.second.is_table() && section.second.contains("server_url")
+            && section.second.at("server_url").as_string() == server_uri) {
+            return section.first;
+        }
+    }
+    return "";
+}
+
+/***
+ * rebuild model input the way server decoded it
+ * @param record
+ * @param input
+ * @return
+ */
+bool make_model_input(const slow_request_record& record, mat_input& input) {
+    if (record.raw_width > 0) {
+        auto raw_bytes = static_cast<size_t>(record.raw_width) * record.raw_height * record.raw_channels;
+        if (record.image_data.size() < raw_bytes) {
+            return false;
+        }
+        input.input_image = cv::Mat(
+            record.raw_height, record.raw_width, CV_8UC(record.raw_channels),
+            const_cast<char*>(record.image_data.data())).clone();
+    } else {
+        cv::Mat image_buffer(1, static_cast<int>(record.image_data.size()), CV_8UC1,
+                             const_cast<char*>(record.image_data.data()));
+        input.input_image = cv::imdecode(image_buffer, cv::IMREAD_UNCHANGED);
+    }
+    return !input.input_image.empty();
+}
+
+int main(int argc, char** argv) {
+
+    google::InitGoogleLogging(argv[0]);
+    google::InstallFailureSignalHandler();
+    google::SetStderrLogging(google::GLOG_INFO);
+
+    if (argc != 3 && argc != 4) {
+        LOG(INFO) << "wrong usage";
+        LOG(INFO) << "exe server_config_file_path capture_file_path [loop_times]";
+        return -1;
+    }
+
+    std::string cfg_file_path = argv[1];
+    if (!FilePathUtil::is_file_exist(cfg_file_path)) {
+        LOG(ERROR) << "server config file: " << cfg_file_path << " not exist";
+        return -1;
+    }
+    std::string capture_file_path = argv[2];
+    std::vector<slow_request_record> records;
+    if (!SlowRequestSampler::load(capture_file_path, records)) {
+        LOG(ERROR) << "capture file: " << capture_file_path << " not exist or corrupted";
+        return -1;
+    }
+    if (records.empty()) {
+        LOG(INFO) << "no request captured in: " << capture_file_path;
+        return 0;
+    }
+    int loop_times = argc == 4 ? std::max(1, std::stoi(argv[3])) : 10;
+
+    auto config = toml::parse(cfg_file_path);
+    auto server_section_name = find_server_section(config, records[0].server_uri);
+    if (server_section_name.empty()) {
+        LOG(ERROR) << "no server section with server_url: " << records[0].server_uri << " in " << cfg_file_path;
+        return -1;
+    }
+    auto runner = create_model_runner(config, server_section_name);
+    if (!runner) {
+        return -1;
+    }
+    LOG(INFO) << "replay " << records.size() << " requests captured by " << server_section_name
+              << ", loop times: " << loop_times;
+
+    bool warmed_up = false;
+    for (const auto& record : records) {
+        std::string captured_stages;
+        for (const auto& stage : record.stage_ms) {
+            captured_stages += " " + stage.first + ": " + std::to_string(stage.second) + " ms";
+        }
+        LOG(INFO) << "task id: " << record.task_id << " worker: " << record.worker_id << " status: " << record.status
+                  << " captured total: " << record.total_ms << " ms," << captured_stages;
+
+        mat_input input;
+        auto decode_start_ts = Timestamp::now();
+        if (!make_model_input(record, input)) {
+            LOG(WARNING) << "task id: " << record.task_id << " captured image can not be decoded, skip it";
+            continue;
+        }
+        auto decode_time_consuming = (Timestamp::now() - decode_start_ts) * 1000;
+        // first run pays for lazy allocations of the model, keep it out of the numbers
+        if (!warmed_up) {
+            runner(input);
+            warmed_up = true;
+        }
+
+        double min_ms = 0;
+        double max_ms = 0;
+        double sum_ms = 0;
+        StatusCode status = StatusCode::OK;
+        for (int i = 0; i < loop_times; ++i) {
+            auto run_start_ts = Timestamp::now();
+            status = runner(input);
+            auto run_ms = (Timestamp::now() - run_start_ts) * 1000;
+            min_ms = i == 0 ? run_ms : std::min(min_ms, run_ms);
+            max_ms = std::max(max_ms, run_ms);
+            sum_ms += run_ms;
+        }
+        LOG(INFO) << "task id: " << record.task_id << " replayed image: " << input.input_image.size()
+                  << " decode: " << decode_time_consuming << " ms, model run avg: " << sum_ms / loop_times
+                  << " ms, min: " << min_ms << " ms, max: " << max_ms << " ms, status: "
+                  << jinq::common::error_code_to_str(static_cast<int>(status));
+    }
+
+    return 0;
+}
@@ -39,7 +39,11 @@ int main(int argc, char **argv) {
 
     auto server = create_densenet_cls_server("densenet_cls_server");
     server->init(config);
-    if (server->start(port) == 0) {
+    // parent of preforked serving processes only supervises them
+    if (!server->prefork(server_cfg)) {
+        return 0;
+    }
+    if (server->start(port) == 0 && server->start_local(server_cfg) == 0 && server->start_rpc(server_cfg) == 0) {
         wait_group.wait();
         server->stop();
     } else {
@@ -0,0 +1,81 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: model_server_host.cpp
+* Date: 26-10-16
+************************************************/
+
+// host several model servers in one process
+
+#include <glog/logging.h>
+#include <workflow/WFFacilities.h>
+
+#include "factory/server_host_task.h"
+
+using jinq::factory::host::create_hosted_server;
+using jinq::factory::host::create_model_server_host;
+using jinq::server::host::ModelServerHost;
+
+int main(int argc, char** argv) {
+
+    google::InitGoogleLogging(argv[0]);
+    google::InstallFailureSignalHandler();
+    google::SetStderrLogging(google::GLOG_INFO);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+
+    if (argc != 2) {
+        LOG(INFO) << "usage:";
+        LOG(INFO) << "exe cfg_path";
+        return -1;
+    }
+
+    WFFacilities::WaitGroup wait_group(1);
+
+    std::string config_file_path = argv[1];
+    LOG(INFO) << "cfg file path: " << config_file_path;
+    auto config = toml::parse(config_file_path);
+    const auto& host_cfg = config.at("MODEL_SERVER_HOST");
+    auto port = host_cfg.at("port").as_integer();
+    LOG(INFO) << "serve on port: " << port;
+
+    auto server = create_model_server_host("model_server_host");
+    auto* host = dynamic_cast<ModelServerHost*>(server.get());
+
+    // each hosted model is described by a server section in its own server config file
+    const auto& hosted_servers = host_cfg.at("hosted_servers").as_array();
+    for (const auto& hosted : hosted_servers) {
+        std::string section_name = hosted.at("server_section").as_string();
+        std::string server_cfg_path = hosted.at("server_config_file_path").as_string();
+        LOG(INFO) << "load model server: " << section_name << " from: " << server_cfg_path;
+
+        auto server_cfg = toml::parse(server_cfg_path);
+        // hosted servers are forked together with the host, let them validate options against it
+        if (host_cfg.contains("process_nums") && server_cfg.contains(section_name)) {
+            server_cfg.as_table()[section_name].as_table()["process_nums"] = host_cfg.at("process_nums");
+        }
+        auto hosted_server = create_hosted_server(section_name, section_name);
+        if (host->add_server(section_name, server_cfg, std::move(hosted_server)) != jinq::common::StatusCode::OK) {
+            LOG(ERROR) << "Cannot host model server: " << section_name;
+            return -1;
+        }
+    }
+
+    if (server->init(config) != jinq::common::StatusCode::OK) {
+        LOG(ERROR) << "Cannot init model server host";
+        return -1;
+    }
+    // parent of preforked serving processes only supervises them
+    if (!server->prefork(host_cfg)) {
+        return 0;
+    }
+    if (server->start(port) == 0 && server->start_local(host_cfg) == 0 && server->start_rpc(host_cfg) == 0) {
+        wait_group.wait();
+        server->stop();
+    } else {
+        LOG(ERROR) << "Cannot start server";
+        return -1;
+    }
+
+    return 0;
+}
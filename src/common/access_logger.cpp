@@ -0,0 +1,217 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: access_logger.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "access_logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+
+#include "common/time_stamp.h"
+
+namespace jinq {
+namespace common {
+
+namespace {
+
+// lines handed to sink in one call
+const size_t MAX_BATCH_LINES = 512;
+
+std::atomic<uint64_t> g_next_logger_id{1};
+
+/***
+ *
+ * @param micro_sec_since_epoch
+ * @return local time with milliseconds
+ */
+std::string format_time(uint64_t micro_sec_since_epoch) {
+    char millis[8];
+    snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(micro_sec_since_epoch / 1000 % 1000));
+    return Timestamp(micro_sec_since_epoch).to_format_str() + millis;
+}
+}
+
+/***
+ *
+ * @param source
+ * @param sink
+ * @param sample_rate
+ * @param flush_interval_ms
+ * @param buffer_entries
+ */
+AccessLogger::AccessLogger(std::string source, sink_type sink, double sample_rate, int64_t flush_interval_ms,
+                           size_t buffer_entries)
+    : _m_id(g_next_logger_id++)
+    , _m_source(std::move(source))
+    , _m_sink(std::move(sink))
+    , _m_sample_rate(std::min(1.0, std::max(0.0, sample_rate)))
+    , _m_flush_interval_ms(std::max<int64_t>(1, flush_interval_ms))
+    , _m_buffer_entries(std::max<size_t>(1, buffer_entries)) {
+}
+
+/***
+ *
+ */
+AccessLogger::~AccessLogger() {
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        _m_stopped = true;
+    }
+    _m_cv.notify_all();
+    if (_m_flush_thread.joinable()) {
+        _m_flush_thread.join();
+    }
+    flush();
+}
+
+/***
+ *
+ * @return
+ */
+bool AccessLogger::sample() {
+    if (_m_sample_rate >= 1.0) {
+        return true;
+    }
+    // keeps exactly sample rate of entries of each thread without a random generator
+    auto* buffer = local_buffer();
+    buffer->sample_credit += _m_sample_rate;
+    if (buffer->sample_credit < 1.0) {
+        return false;
+    }
+    buffer->sample_credit -= 1.0;
+    return true;
+}
+
+/***
+ *
+ * @param entry
+ * @return
+ */
+bool AccessLogger::log(access_log_entry entry) {
+    auto* buffer = local_buffer();
+    auto tail = buffer->tail.load(std::memory_order_relaxed);
+    if (tail - buffer->head.load(std::memory_order_acquire) >= _m_buffer_entries) {
+        _m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    buffer->entries[tail % _m_buffer_entries] = std::move(entry);
+    buffer->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/***
+ *
+ */
+void AccessLogger::flush() {
+    std::lock_guard<std::mutex> drain_lock(_m_drain_mutex);
+    std::vector<std::shared_ptr<thread_buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        buffers = _m_buffers;
+    }
+
+    std::vector<access_log_entry> entries;
+    for (auto& buffer : buffers) {
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        auto tail = buffer->tail.load(std::memory_order_acquire);
+        for (auto index = head; index != tail; ++index) {
+            entries.push_back(std::move(buffer->entries[index % _m_buffer_entries]));
+        }
+        buffer->head.store(tail, std::memory_order_release);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const access_log_entry& lhs, const access_log_entry& rhs) {
+        return lhs.finished_us < rhs.finished_us;
+    });
+
+    std::string lines;
+    std::string line;
+    size_t line_nums = 0;
+    for (const auto& entry : entries) {
+        format_entry(entry, line);
+        lines += line;
+        if (++line_nums == MAX_BATCH_LINES) {
+            lines.pop_back();
+            _m_sink(lines);
+            lines.clear();
+            line_nums = 0;
+        }
+    }
+    auto dropped = _m_dropped.load(std::memory_order_relaxed);
+    if (dropped != _m_reported_dropped) {
+        lines += "server=" + _m_source + " access_log_dropped=" + std::to_string(dropped - _m_reported_dropped) + "\n";
+        _m_reported_dropped = dropped;
+    }
+    if (!lines.empty()) {
+        lines.pop_back();
+        _m_sink(lines);
+    }
+    _m_written.fetch_add(entries.size(), std::memory_order_relaxed);
+}
+
+/***
+ *
+ * @return
+ */
+AccessLogger::thread_buffer* AccessLogger::local_buffer() {
+    thread_local uint64_t cached_id = 0;
+    thread_local thread_buffer* cached_buffer = nullptr;
+    if (cached_id == _m_id) {
+        return cached_buffer;
+    }
+
+    // a thread may log for several servers hosted in one process
+    thread_local std::unordered_map<uint64_t, std::shared_ptr<thread_buffer>> thread_buffers;
+    auto& buffer = thread_buffers[_m_id];
+    if (buffer == nullptr) {
+        buffer = std::make_shared<thread_buffer>(_m_buffer_entries);
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        _m_buffers.push_back(buffer);
+        if (!_m_flush_thread.joinable() && !_m_stopped) {
+            _m_flush_thread = std::thread(&AccessLogger::flush_loop, this);
+        }
+    }
+    cached_id = _m_id;
+    cached_buffer = buffer.get();
+    return cached_buffer;
+}
+
+/***
+ *
+ */
+void AccessLogger::flush_loop() {
+    std::unique_lock<std::mutex> lock(_m_mutex);
+    while (!_m_stopped) {
+        _m_cv.wait_for(lock, std::chrono::milliseconds(_m_flush_interval_ms), [this] { return _m_stopped; });
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+/***
+ *
+ * @param entry
+ * @param line
+ */
+void AccessLogger::format_entry(const access_log_entry& entry, std::string& line) const {
+    char numbers[256];
+    snprintf(numbers, sizeof(numbers),
+             " status=%d elapse_ms=%.3f wait_worker_ms=%.3f total_ms=%.3f batch_size=%u"
+             " received_jobs=%llu waiting_jobs=%llu finished_jobs=%llu idle_workers=%llu worker_waiters=%llu\n",
+             static_cast<int>(entry.status), entry.elapse_ms, entry.wait_worker_ms, entry.total_ms,
+             static_cast<unsigned int>(entry.batch_size),
+             static_cast<unsigned long long>(entry.received_jobs), static_cast<unsigned long long>(entry.waiting_jobs),
+             static_cast<unsigned long long>(entry.finished_jobs), static_cast<unsigned long long>(entry.idle_workers),
+             static_cast<unsigned long long>(entry.worker_waiters));
+    line = "server=" + _m_source + " task_id=" + entry.task_id
+           + " received_at=\"" + format_time(entry.received_us) + "\" finished_at=\"" + format_time(entry.finished_us)
+           + "\"" + numbers;
+}
+
+}
+}
@@ -0,0 +1,171 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: access_logger.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_ACCESS_LOGGER_H
+#define MM_AI_SERVER_ACCESS_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jinq {
+namespace common {
+
+/***
+ * structured fields of one served request, timestamps are formatted on flush thread
+ */
+struct access_log_entry {
+    std::string task_id;
+    uint64_t received_us = 0;
+    uint64_t finished_us = 0;
+    int32_t status = 0;
+    double elapse_ms = 0;
+    double wait_worker_ms = 0;
+    double total_ms = 0;
+    uint32_t batch_size = 1;
+    uint64_t received_jobs = 0;
+    uint64_t waiting_jobs = 0;
+    uint64_t finished_jobs = 0;
+    uint64_t idle_workers = 0;
+    uint64_t worker_waiters = 0;
+};
+
+/***
+ * Access log written off the request path. Every logging thread appends entries to its own single
+ * producer ring buffer without locking, a background thread drains all buffers periodically, formats
+ * them and hands them to sink in batches. Entries are dropped rather than waited for once a thread's
+ * buffer is full. Flush thread is started by the first logged entry, so a logger created before
+ * fork works in the forked children
+ */
+class AccessLogger {
+public:
+    using sink_type = std::function<void(const std::string& lines)>;
+
+    /***
+     * constructor
+     * @param source : logged as server field of every line
+     * @param sink : receives formatted lines of one batch, one line per entry
+     * @param sample_rate : fraction of entries kept by sample(), in [0, 1]
+     * @param flush_interval_ms
+     * @param buffer_entries : ring buffer capacity of each logging thread
+     */
+    AccessLogger(std::string source, sink_type sink, double sample_rate, int64_t flush_interval_ms,
+                 size_t buffer_entries);
+
+    /***
+     * stop flush thread and write remaining entries
+     */
+    ~AccessLogger();
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    AccessLogger(const AccessLogger& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    AccessLogger& operator=(const AccessLogger& transformer) = delete;
+
+    /***
+     * decide whether the next entry of calling thread is logged, call it before building the entry
+     * @return
+     */
+    bool sample();
+
+    /***
+     * append entry to buffer of calling thread
+     * @param entry
+     * @return false if buffer is full and entry dropped
+     */
+    bool log(access_log_entry entry);
+
+    /***
+     * drain and write buffered entries on calling thread
+     */
+    void flush();
+
+    /***
+     *
+     * @return
+     */
+    uint64_t written() const {
+        return _m_written.load(std::memory_order_relaxed);
+    }
+
+    /***
+     *
+     * @return
+     */
+    uint64_t dropped() const {
+        return _m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct thread_buffer {
+        explicit thread_buffer(size_t capacity) : entries(capacity) {}
+        std::vector<access_log_entry> entries;
+        // consumer index, advanced by flushing thread only
+        std::atomic<size_t> head{0};
+        // producer index, advanced by owner thread only
+        std::atomic<size_t> tail{0};
+        // sampling credit, owner thread only
+        double sample_credit = 0;
+    };
+
+    /***
+     * buffer of calling thread, registered on first use
+     * @return
+     */
+    thread_buffer* local_buffer();
+
+    /***
+     *
+     */
+    void flush_loop();
+
+    /***
+     *
+     * @param entry
+     * @param line
+     */
+    void format_entry(const access_log_entry& entry, std::string& line) const;
+
+private:
+    // distinguishes loggers in thread local buffer tables, never reused
+    uint64_t _m_id = 0;
+    std::string _m_source;
+    sink_type _m_sink;
+    double _m_sample_rate = 1.0;
+    int64_t _m_flush_interval_ms = 100;
+    size_t _m_buffer_entries = 4096;
+
+    std::mutex _m_mutex;
+    std::condition_variable _m_cv;
+    bool _m_stopped = false;
+    std::thread _m_flush_thread;
+    std::vector<std::shared_ptr<thread_buffer>> _m_buffers;
+    // buffers have one consumer at a time
+    std::mutex _m_drain_mutex;
+
+    std::atomic<uint64_t> _m_written{0};
+    std::atomic<uint64_t> _m_dropped{0};
+    uint64_t _m_reported_dropped = 0;
+};
+}
+}
+
+#endif //MM_AI_SERVER_ACCESS_LOGGER_H
@@ -7,6 +7,8 @@
 
 #include "base64.h"
 
+#include <cstdint>
+
 namespace jinq {
 namespace common {
 
@@ -18,10 +20,6 @@ const std::string& get_base64_chars() {
     return base64_chars;
 }
 
-static bool is_base64(unsigned char c) {
-    return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
 void encode_char_array(unsigned char *encode_block, const unsigned char *decode_block) {
     encode_block[0] = (decode_block[0] & 0xfc) >> 2;
     encode_block[1] = ((decode_block[0] & 0x03) << 4) + ((decode_block[1] & 0xf0) >> 4);
@@ -120,47 +118,64 @@ std::string Base64::base64_encode(const std::string& input) {
 * @return
 */
 std::string Base64::base64_decode(const std::string& encoded_string) {
-
-    size_t in_len = encoded_string.size();
-    int i = 0;
-    int j;
-    int in_ = 0;
-    unsigned char char_array_4[4], char_array_3[3];
     std::string ret;
+    base64_decode(encoded_string.data(), encoded_string.size(), ret);
+    return ret;
+}
 
-    while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_];
-        in_++;
-        if (i ==4) {
-            for (i = 0; i <4; i++) {
-                char_array_4[i] = get_base64_chars().find(static_cast<char>(char_array_4[i])) & 0xff;
+/***
+* Base64 decode
+* @param data
+* @param size
+* @param output
+* @return
+*/
+size_t Base64::base64_decode(const char* data, size_t size, std::string& output) {
+    // reverse lookup table, 0xff marks non base64 chars
+    static const struct decode_table {
+        unsigned char values[256];
+        decode_table() {
+            for (auto& value : values) {
+                value = 0xff;
             }
-
-            char_array_3[0] = ( char_array_4[0] << 2       ) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) +   char_array_4[3];
-
-            for (i = 0; (i < 3); i++) {
-                ret += static_cast<char>(char_array_3[i]);
+            const auto& chars = get_base64_chars();
+            for (size_t i = 0; i < chars.size(); ++i) {
+                values[static_cast<unsigned char>(chars[i])] = static_cast<unsigned char>(i);
             }
-            i = 0;
         }
-    }
-
-    if (i) {
-        for (j = 0; j < i; j++) {
-            char_array_4[j] = get_base64_chars().find(static_cast<char>(char_array_4[j])) & 0xff;
+    } table;
+
+    output.resize(size / 4 * 3 + 3);
+    auto* out = reinterpret_cast<unsigned char*>(&output[0]);
+    size_t out_len = 0;
+    uint32_t block = 0;
+    int block_chars = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char value = table.values[static_cast<unsigned char>(data[i])];
+        if (value == 0xff) {
+            break;
         }
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-
-        for (j = 0; (j < i - 1); j++) {
-            ret += static_cast<char>(char_array_3[j]);
+        block = (block << 6) | value;
+        if (++block_chars == 4) {
+            out[out_len++] = static_cast<unsigned char>(block >> 16);
+            out[out_len++] = static_cast<unsigned char>(block >> 8);
+            out[out_len++] = static_cast<unsigned char>(block);
+            block = 0;
+            block_chars = 0;
         }
     }
 
-    return ret;
+    // tail of 2 or 3 chars carries 1 or 2 bytes
+    if (block_chars == 2) {
+        out[out_len++] = static_cast<unsigned char>(block >> 4);
+    } else if (block_chars == 3) {
+        out[out_len++] = static_cast<unsigned char>(block >> 10);
+        out[out_len++] = static_cast<unsigned char>(block >> 2);
+    }
+
+    output.resize(out_len);
+    return out_len;
 }
 }
 }
@@ -57,6 +57,16 @@ public:
      * @return
      */
     static std::string base64_decode(const std::string& s);
+
+    /***
+     * Base64 decode into output which is sized once up front, decoding stops at padding or the first
+     * non base64 char
+     * @param data
+     * @param size
+     * @param output
+     * @return decoded bytes
+     */
+    static size_t base64_decode(const char* data, size_t size, std::string& output);
 };
 }
 }
@@ -0,0 +1,164 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_affinity.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "cpu_affinity.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param cpu_list
+ * @return
+ */
+std::vector<int> CpuAffinity::parse_cpu_list(const std::string& cpu_list) {
+    std::vector<int> cores;
+    std::stringstream ss(cpu_list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range.find_first_of("0123456789") == std::string::npos) {
+            continue;
+        }
+        auto pos = range.find('-');
+        int first = static_cast<int>(strtol(range.c_str(), nullptr, 10));
+        int last = pos == std::string::npos ? first : static_cast<int>(strtol(range.c_str() + pos + 1, nullptr, 10));
+        for (int core = first; core <= last; ++core) {
+            cores.push_back(core);
+        }
+    }
+    return cores;
+}
+
+/***
+ *
+ * @return
+ */
+std::vector<int> CpuAffinity::numa_ordered_cores() {
+    std::vector<int> cores;
+    for (int node = 0; ; ++node) {
+        std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpu_list_file.is_open()) {
+            break;
+        }
+        std::string cpu_list;
+        std::getline(cpu_list_file, cpu_list);
+        auto node_cores = parse_cpu_list(cpu_list);
+        cores.insert(cores.end(), node_cores.begin(), node_cores.end());
+    }
+
+    if (cores.empty()) {
+        int core_nums = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int core = 0; core < core_nums; ++core) {
+            cores.push_back(core);
+        }
+    }
+    return cores;
+}
+
+/***
+ *
+ * @param cores
+ * @param worker_index
+ * @param cores_per_worker
+ * @param core_offset
+ * @return
+ */
+std::vector<int> CpuAffinity::worker_cores(
+    const std::vector<int>& cores, int worker_index, int cores_per_worker, int core_offset) {
+    std::vector<int> result;
+    if (cores.empty() || cores_per_worker <= 0) {
+        return result;
+    }
+
+    // wrap around once workers need more cores than the host has
+    auto core_nums = static_cast<int>(cores.size());
+    for (int index = 0; index < std::min(cores_per_worker, core_nums); ++index) {
+        int pos = ((core_offset + worker_index * cores_per_worker + index) % core_nums + core_nums) % core_nums;
+        result.push_back(cores[pos]);
+    }
+    return result;
+}
+
+/***
+ *
+ * @param cores
+ * @return
+ */
+bool CpuAffinity::bind_current_thread(const std::vector<int>& cores) {
+#ifdef __linux__
+    if (cores.empty()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto core : cores) {
+        if (core >= 0 && core < CPU_SETSIZE) {
+            CPU_SET(core, &cpu_set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+/***
+ *
+ * @param cores
+ * @return
+ */
+bool CpuAffinity::current_thread_cores(std::vector<int>& cores) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        return false;
+    }
+    cores.clear();
+    for (int core = 0; core < CPU_SETSIZE; ++core) {
+        if (CPU_ISSET(core, &cpu_set)) {
+            cores.push_back(core);
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/***
+ *
+ * @param cores
+ */
+ScopedCpuAffinity::ScopedCpuAffinity(const std::vector<int>& cores) {
+    if (cores.empty() || !CpuAffinity::current_thread_cores(_m_previous_cores)) {
+        return;
+    }
+    _m_bound = CpuAffinity::bind_current_thread(cores);
+}
+
+/***
+ *
+ */
+ScopedCpuAffinity::~ScopedCpuAffinity() {
+    if (_m_bound) {
+        CpuAffinity::bind_current_thread(_m_previous_cores);
+    }
+}
+}
+}
@@ -0,0 +1,93 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_affinity.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_CPU_AFFINITY_H
+#define MM_AI_SERVER_CPU_AFFINITY_H
+
+#include <string>
+#include <vector>
+
+namespace jinq {
+namespace common {
+class CpuAffinity {
+public:
+    /***
+     * parse linux cpu list format, e.g. "0-3,8,10-11"
+     * @param cpu_list
+     * @return
+     */
+    static std::vector<int> parse_cpu_list(const std::string& cpu_list);
+
+    /***
+     * online cores ordered by numa node, cores of the same node are adjacent
+     * @return
+     */
+    static std::vector<int> numa_ordered_cores();
+
+    /***
+     * dedicated core set of a worker, taken as a contiguous block of numa ordered cores
+     * @param cores: numa ordered cores
+     * @param worker_index
+     * @param cores_per_worker
+     * @param core_offset: cores skipped at the beginning, e.g. reserved for io threads
+     * @return
+     */
+    static std::vector<int> worker_cores(
+        const std::vector<int>& cores, int worker_index, int cores_per_worker, int core_offset);
+
+    /***
+     * pin calling thread to cores
+     * @param cores
+     * @return
+     */
+    static bool bind_current_thread(const std::vector<int>& cores);
+
+    /***
+     * cores calling thread is allowed to run on
+     * @param cores
+     * @return
+     */
+    static bool current_thread_cores(std::vector<int>& cores);
+};
+
+/***
+ * pin calling thread to cores during its scope, previous affinity is restored afterwards
+ */
+class ScopedCpuAffinity {
+public:
+    /***
+     * constructor
+     * @param cores: empty means do nothing
+     */
+    explicit ScopedCpuAffinity(const std::vector<int>& cores);
+
+    /***
+     *
+     */
+    ~ScopedCpuAffinity();
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    ScopedCpuAffinity(const ScopedCpuAffinity& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    ScopedCpuAffinity& operator=(const ScopedCpuAffinity& transformer) = delete;
+
+private:
+    bool _m_bound = false;
+    std::vector<int> _m_previous_cores;
+};
+}
+}
+
+#endif //MM_AI_SERVER_CPU_AFFINITY_H
@@ -0,0 +1,73 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_usage.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "cpu_usage.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param stat_line
+ * @param busy_ticks
+ * @param total_ticks
+ * @return
+ */
+bool CpuUsageSampler::parse_proc_stat(const std::string& stat_line, uint64_t& busy_ticks, uint64_t& total_ticks) {
+    std::istringstream iss(stat_line);
+    std::string name;
+    iss >> name;
+    if (name != "cpu") {
+        return false;
+    }
+
+    // user nice system idle iowait irq softirq steal ...
+    uint64_t ticks = 0;
+    uint64_t idle_ticks = 0;
+    int index = 0;
+    total_ticks = 0;
+    while (iss >> ticks) {
+        total_ticks += ticks;
+        if (index == 3 || index == 4) {
+            idle_ticks += ticks;
+        }
+        index++;
+    }
+    if (index < 4) {
+        return false;
+    }
+    busy_ticks = total_ticks - idle_ticks;
+    return true;
+}
+
+/***
+ *
+ * @return
+ */
+double CpuUsageSampler::sample() {
+    std::ifstream stat_file("/proc/stat");
+    std::string stat_line;
+    uint64_t busy_ticks = 0;
+    uint64_t total_ticks = 0;
+    if (!stat_file.is_open() || !std::getline(stat_file, stat_line)
+            || !parse_proc_stat(stat_line, busy_ticks, total_ticks)) {
+        return -1.0;
+    }
+
+    double usage = -1.0;
+    if (_m_last_total_ticks != 0 && total_ticks > _m_last_total_ticks) {
+        usage = static_cast<double>(busy_ticks - _m_last_busy_ticks) / static_cast<double>(total_ticks - _m_last_total_ticks);
+    }
+    _m_last_busy_ticks = busy_ticks;
+    _m_last_total_ticks = total_ticks;
+    return usage;
+}
+}
+}
@@ -0,0 +1,40 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_usage.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_CPU_USAGE_H
+#define MM_AI_SERVER_CPU_USAGE_H
+
+#include <cstdint>
+#include <string>
+
+namespace jinq {
+namespace common {
+class CpuUsageSampler {
+public:
+    /***
+     * parse aggregated "cpu" line of /proc/stat
+     * @param stat_line
+     * @param busy_ticks
+     * @param total_ticks
+     * @return
+     */
+    static bool parse_proc_stat(const std::string& stat_line, uint64_t& busy_ticks, uint64_t& total_ticks);
+
+    /***
+     * host cpu usage since last sample
+     * @return usage in [0, 1], negative if unavailable
+     */
+    double sample();
+
+private:
+    uint64_t _m_last_busy_ticks = 0;
+    uint64_t _m_last_total_ticks = 0;
+};
+}
+}
+
+#endif //MM_AI_SERVER_CPU_USAGE_H
@@ -0,0 +1,69 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: hash_util.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "hash_util.h"
+
+#include <cstring>
+
+namespace jinq {
+namespace common {
+namespace hash_util {
+
+/***
+ *
+ * @param data
+ * @param size
+ * @param seed
+ * @return
+ */
+uint64_t murmur_hash64(const void* data, size_t size, uint64_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = seed ^ (size * m);
+
+    auto* bytes = static_cast<const unsigned char*>(data);
+    size_t block_nums = size / 8;
+    for (size_t index = 0; index < block_nums; ++index) {
+        uint64_t k = 0;
+        std::memcpy(&k, bytes + index * 8, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const unsigned char* tail = bytes + block_nums * 8;
+    switch (size & 7) {
+    case 7: h ^= static_cast<uint64_t>(tail[6]) << 48;
+        [[fallthrough]];
+    case 6: h ^= static_cast<uint64_t>(tail[5]) << 40;
+        [[fallthrough]];
+    case 5: h ^= static_cast<uint64_t>(tail[4]) << 32;
+        [[fallthrough]];
+    case 4: h ^= static_cast<uint64_t>(tail[3]) << 24;
+        [[fallthrough]];
+    case 3: h ^= static_cast<uint64_t>(tail[2]) << 16;
+        [[fallthrough]];
+    case 2: h ^= static_cast<uint64_t>(tail[1]) << 8;
+        [[fallthrough]];
+    case 1: h ^= static_cast<uint64_t>(tail[0]);
+        h *= m;
+        [[fallthrough]];
+    default:
+        break;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+}
+}
+}
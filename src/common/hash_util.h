@@ -0,0 +1,42 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: hash_util.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_HASH_UTIL_H
+#define MM_AI_SERVER_HASH_UTIL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jinq {
+namespace common {
+namespace hash_util {
+
+/***
+ * non-cryptographic 64 bit hash (MurmurHash64A), much faster than md5 on large buffers
+ * @param data
+ * @param size
+ * @param seed
+ * @return
+ */
+uint64_t murmur_hash64(const void* data, size_t size, uint64_t seed = 0);
+
+/***
+ *
+ * @param data
+ * @param seed
+ * @return
+ */
+inline uint64_t murmur_hash64(const std::string& data, uint64_t seed = 0) {
+    return murmur_hash64(data.data(), data.size(), seed);
+}
+
+}
+}
+}
+
+#endif //MM_AI_SERVER_HASH_UTIL_H
@@ -8,10 +8,15 @@
 #include "http_utils.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <random>
 #include <future>
 #include <fstream>
 
+#include <zlib.h>
+
 namespace jinq {
 namespace common {
 namespace http_util {
@@ -89,6 +94,91 @@ const std::string &MultipartParser::gen_body_content() {
     return _m_body_content;
 }
 
+/***
+ *
+ * @param content_type
+ */
+MultipartReader::MultipartReader(const std::string &content_type) {
+    auto pos = content_type.find("boundary=");
+    if (pos == std::string::npos) {
+        return;
+    }
+    _m_boundary = content_type.substr(pos + std::strlen("boundary="));
+    auto end_pos = _m_boundary.find(';');
+    if (end_pos != std::string::npos) {
+        _m_boundary.resize(end_pos);
+    }
+    if (_m_boundary.size() >= 2 && _m_boundary.front() == '"' && _m_boundary.back() == '"') {
+        _m_boundary = _m_boundary.substr(1, _m_boundary.size() - 2);
+    }
+}
+
+/***
+ *
+ * @param body
+ * @param size
+ * @return
+ */
+bool MultipartReader::parse(const char *body, size_t size) {
+    _m_fields.clear();
+    if (_m_boundary.empty() || body == nullptr) {
+        return false;
+    }
+
+    const std::string delimiter = "--" + _m_boundary;
+    const std::string field_delimiter = "\r\n" + delimiter;
+    const char* body_end = body + size;
+    const char* cursor = std::search(body, body_end, delimiter.begin(), delimiter.end());
+    if (cursor == body_end) {
+        return false;
+    }
+    cursor += delimiter.size();
+
+    while (true) {
+        // close delimiter
+        if (body_end - cursor >= 2 && cursor[0] == '-' && cursor[1] == '-') {
+            return true;
+        }
+        if (body_end - cursor < 2 || cursor[0] != '\r' || cursor[1] != '\n') {
+            return false;
+        }
+        cursor += 2;
+
+        // field headers end with an empty line
+        const char* headers_end_mark = "\r\n\r\n";
+        const char* headers_end = std::search(cursor, body_end, headers_end_mark, headers_end_mark + 4);
+        if (headers_end == body_end) {
+            return false;
+        }
+        multipart_field field;
+        parse_field_headers(cursor, headers_end, field);
+
+        const char* data_begin = headers_end + 4;
+        const char* data_end = std::search(data_begin, body_end, field_delimiter.begin(), field_delimiter.end());
+        if (data_end == body_end) {
+            return false;
+        }
+        field.data = data_begin;
+        field.size = static_cast<size_t>(data_end - data_begin);
+        _m_fields.push_back(std::move(field));
+        cursor = data_end + field_delimiter.size();
+    }
+}
+
+/***
+ *
+ * @param name
+ * @return
+ */
+const multipart_field* MultipartReader::find_field(const std::string &name) const {
+    for (auto& field : _m_fields) {
+        if (field.name == name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
 /****** Private Function Sets ************/
 
 /***
@@ -120,6 +210,122 @@ void MultipartParser::get_file_name_type(
     }
 }
 
+/***
+ *
+ * @param begin
+ * @param end
+ * @param field
+ */
+void MultipartReader::parse_field_headers(const char *begin, const char *end, multipart_field &field) {
+    auto get_param = [](const std::string& line, const std::string& key) -> std::string {
+        // skip keys which only end with the given key, eg. filename for name
+        auto pos = line.find(key + "=\"");
+        while (pos != std::string::npos && pos > 0 && std::isalpha(line[pos - 1])) {
+            pos = line.find(key + "=\"", pos + 1);
+        }
+        if (pos == std::string::npos) {
+            return "";
+        }
+        pos += key.size() + 2;
+        auto end_pos = line.find('"', pos);
+        return end_pos == std::string::npos ? "" : line.substr(pos, end_pos - pos);
+    };
+
+    std::string headers(begin, end);
+    size_t line_begin = 0;
+    while (line_begin < headers.size()) {
+        auto line_end = headers.find("\r\n", line_begin);
+        if (line_end == std::string::npos) {
+            line_end = headers.size();
+        }
+        std::string line = headers.substr(line_begin, line_end - line_begin);
+        line_begin = line_end + 2;
+
+        auto colon_pos = line.find(':');
+        if (colon_pos == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon_pos);
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        if (key == "content-disposition") {
+            field.name = get_param(line, "name");
+            field.file_name = get_param(line, "filename");
+        } else if (key == "content-type") {
+            auto value_pos = line.find_first_not_of(' ', colon_pos + 1);
+            field.content_type = value_pos == std::string::npos ? "" : line.substr(value_pos);
+        }
+    }
+}
+
+/***
+ *
+ * @param accept_encoding
+ * @param coding
+ * @return
+ */
+bool accepts_encoding(const std::string& accept_encoding, const std::string& coding) {
+    bool wildcard_accepted = false;
+    size_t item_begin = 0;
+    while (item_begin <= accept_encoding.size()) {
+        auto item_end = accept_encoding.find(',', item_begin);
+        if (item_end == std::string::npos) {
+            item_end = accept_encoding.size();
+        }
+        std::string item = accept_encoding.substr(item_begin, item_end - item_begin);
+        item_begin = item_end + 1;
+
+        // coding name and optional quality value, e.g. "gzip;q=0.5"
+        auto param_pos = item.find(';');
+        std::string name = item.substr(0, param_pos);
+        name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        double quality = 1.0;
+        if (param_pos != std::string::npos) {
+            auto q_pos = item.find("q=", param_pos);
+            if (q_pos != std::string::npos) {
+                quality = std::strtod(item.c_str() + q_pos + 2, nullptr);
+            }
+        }
+        if (name == coding) {
+            return quality > 0;
+        }
+        if (name == "*") {
+            wildcard_accepted = quality > 0;
+        }
+    }
+    return wildcard_accepted;
+}
+
+/***
+ *
+ * @param data
+ * @param size
+ * @param level
+ * @param output
+ * @return
+ */
+bool gzip_compress(const char* data, size_t size, int level, std::string& output) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // window bits above 15 asks zlib for gzip header and trailer instead of zlib ones
+    if (deflateInit2(&stream, std::min(9, std::max(1, level)), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    output.resize(deflateBound(&stream, static_cast<uLong>(size)) + 18);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    auto ret = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        output.clear();
+        return false;
+    }
+    output.resize(stream.total_out);
+    return true;
+}
+
 }
 }
 }
\ No newline at end of file
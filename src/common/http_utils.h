@@ -71,6 +71,80 @@ private:
     std::vector<std::pair<std::string, std::string> > _m_files;
 };
 
+struct multipart_field {
+    std::string name;
+    std::string file_name;
+    std::string content_type;
+    // points into the parsed body, no copy is made
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+class MultipartReader {
+public:
+    /***
+     *
+     * @param content_type: request's Content-Type header carrying the boundary
+     */
+    explicit MultipartReader(const std::string& content_type);
+
+    /***
+     *
+     * @return
+     */
+    inline const std::string& boundary() const {
+        return _m_boundary;
+    }
+
+    /***
+     * split a multipart/form-data body into fields. The body must outlive the fields
+     * @param body
+     * @param size
+     * @return false if body is malformed
+     */
+    bool parse(const char* body, size_t size);
+
+    /***
+     *
+     * @return
+     */
+    inline const std::vector<multipart_field>& fields() const {
+        return _m_fields;
+    }
+
+    /***
+     *
+     * @param name
+     * @return nullptr if not found
+     */
+    const multipart_field* find_field(const std::string& name) const;
+
+private:
+    static void parse_field_headers(const char* begin, const char* end, multipart_field& field);
+
+private:
+    std::string _m_boundary;
+    std::vector<multipart_field> _m_fields;
+};
+
+/***
+ * whether Accept-Encoding header value accepts the content coding, "*" matches any coding and q=0 refuses it
+ * @param accept_encoding
+ * @param coding : lower case, e.g. gzip
+ * @return
+ */
+bool accepts_encoding(const std::string& accept_encoding, const std::string& coding);
+
+/***
+ * compress data into gzip format
+ * @param data
+ * @param size
+ * @param level : zlib compression level in [1, 9]
+ * @param output
+ * @return false if compression failed
+ */
+bool gzip_compress(const char* data, size_t size, int level, std::string& output);
+
 }
 }
 }
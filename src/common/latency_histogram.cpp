@@ -0,0 +1,95 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: latency_histogram.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param bucket_bounds
+ */
+LatencyHistogram::LatencyHistogram(const std::vector<double> &bucket_bounds)
+    : _m_bucket_bounds(bucket_bounds)
+    , _m_bucket_counts(bucket_bounds.size() + 1) {
+    std::sort(_m_bucket_bounds.begin(), _m_bucket_bounds.end());
+}
+
+/***
+ *
+ * @param elapse_ms
+ */
+void LatencyHistogram::observe(double elapse_ms) {
+    if (elapse_ms < 0) {
+        elapse_ms = 0;
+    }
+    auto bucket = std::lower_bound(_m_bucket_bounds.begin(), _m_bucket_bounds.end(), elapse_ms) - _m_bucket_bounds.begin();
+    _m_bucket_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    _m_count.fetch_add(1, std::memory_order_relaxed);
+    _m_sum_us.fetch_add(static_cast<uint64_t>(elapse_ms * 1000), std::memory_order_relaxed);
+}
+
+/***
+ *
+ * @return
+ */
+uint64_t LatencyHistogram::count() const {
+    return _m_count.load(std::memory_order_relaxed);
+}
+
+/***
+ *
+ * @return
+ */
+double LatencyHistogram::sum() const {
+    return static_cast<double>(_m_sum_us.load(std::memory_order_relaxed)) / 1000.0;
+}
+
+/***
+ *
+ * @param metric_name
+ * @param labels
+ * @param output
+ */
+void LatencyHistogram::to_prometheus(const std::string &metric_name, const std::string &labels, std::string &output) const {
+    std::ostringstream oss;
+    std::string label_prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative_count = 0;
+
+    for (size_t index = 0; index < _m_bucket_counts.size(); ++index) {
+        cumulative_count += _m_bucket_counts[index].load(std::memory_order_relaxed);
+        oss << metric_name << "_bucket{" << label_prefix << "le=\"";
+        if (index < _m_bucket_bounds.size()) {
+            oss << _m_bucket_bounds[index];
+        } else {
+            oss << "+Inf";
+        }
+        oss << "\"} " << cumulative_count << "\n";
+    }
+    std::string label_block = labels.empty() ? "" : "{" + labels + "}";
+    oss << metric_name << "_sum" << label_block << " " << sum() << "\n";
+    oss << metric_name << "_count" << label_block << " " << cumulative_count << "\n";
+    output += oss.str();
+}
+
+/***
+ *
+ * @return
+ */
+const std::vector<double>& LatencyHistogram::default_bucket_bounds() {
+    static const std::vector<double> bucket_bounds = {
+        0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+    };
+    return bucket_bounds;
+}
+
+}
+}
@@ -0,0 +1,85 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: latency_histogram.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_LATENCY_HISTOGRAM_H
+#define MM_AI_SERVER_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace jinq {
+namespace common {
+class LatencyHistogram {
+public:
+    /***
+     * constructor
+     * @param bucket_bounds: upper bounds of buckets in milliseconds, ascending
+     */
+    explicit LatencyHistogram(const std::vector<double>& bucket_bounds = default_bucket_bounds());
+
+    /***
+     *
+     */
+    ~LatencyHistogram() = default;
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    LatencyHistogram(const LatencyHistogram& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    LatencyHistogram& operator=(const LatencyHistogram& transformer) = delete;
+
+    /***
+     * record one sample, lock free
+     * @param elapse_ms
+     */
+    void observe(double elapse_ms);
+
+    /***
+     *
+     * @return
+     */
+    uint64_t count() const;
+
+    /***
+     *
+     * @return sum of samples in milliseconds
+     */
+    double sum() const;
+
+    /***
+     * append prometheus text exposition of this histogram
+     * @param metric_name
+     * @param labels: extra labels like a="1",b="2", may be empty
+     * @param output
+     */
+    void to_prometheus(const std::string& metric_name, const std::string& labels, std::string& output) const;
+
+    /***
+     *
+     * @return
+     */
+    static const std::vector<double>& default_bucket_bounds();
+
+private:
+    std::vector<double> _m_bucket_bounds;
+    // last bucket is +Inf
+    std::vector<std::atomic<uint64_t> > _m_bucket_counts;
+    std::atomic<uint64_t> _m_count{0};
+    std::atomic<uint64_t> _m_sum_us{0};
+};
+}
+}
+
+#endif //MM_AI_SERVER_LATENCY_HISTOGRAM_H
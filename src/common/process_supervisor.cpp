@@ -0,0 +1,213 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: process_supervisor.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "process_supervisor.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+namespace jinq {
+namespace common {
+
+namespace {
+
+#ifndef _WIN32
+const int STOP_SIGNALS[] = {SIGTERM, SIGINT, SIGHUP};
+const int STOP_SIGNAL_NUMS = sizeof(STOP_SIGNALS) / sizeof(STOP_SIGNALS[0]);
+
+volatile sig_atomic_t g_stop_signal = 0;
+
+/***
+ *
+ * @param sig
+ */
+void on_stop_signal(int sig) {
+    g_stop_signal = sig;
+}
+#endif
+
+/***
+ *
+ * @return
+ */
+long long now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+/***
+ *
+ * @param process_nums
+ * @param restart_delay_ms
+ */
+ProcessSupervisor::ProcessSupervisor(int process_nums, int restart_delay_ms)
+    : _m_process_nums(std::max(1, process_nums)), _m_restart_delay_ms(std::max(0, restart_delay_ms)) {
+}
+
+/***
+ *
+ * @param process_index
+ * @return
+ */
+bool ProcessSupervisor::run(int& process_index) {
+#ifndef _WIN32
+    _m_pids.assign(_m_process_nums, 0);
+    _m_fork_ms.assign(_m_process_nums, 0);
+    _m_failed = false;
+
+    // no SA_RESTART, so that waitpid returns once a stop signal arrives
+    g_stop_signal = 0;
+    struct sigaction action{};
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    struct sigaction old_actions[STOP_SIGNAL_NUMS];
+    for (int i = 0; i < STOP_SIGNAL_NUMS; ++i) {
+        sigaction(STOP_SIGNALS[i], &action, &old_actions[i]);
+    }
+    auto restore_actions = [&old_actions]() {
+        for (int i = 0; i < STOP_SIGNAL_NUMS; ++i) {
+            sigaction(STOP_SIGNALS[i], &old_actions[i], nullptr);
+        }
+    };
+
+    int running_nums = 0;
+    for (int index = 0; index < _m_process_nums; ++index) {
+        auto pid = fork_child(index);
+        if (pid == 0) {
+            restore_actions();
+            process_index = index;
+            return true;
+        }
+        if (pid < 0) {
+            _m_failed = true;
+            stop_children(SIGTERM);
+            restore_actions();
+            return false;
+        }
+        running_nums++;
+    }
+
+    while (running_nums > 0) {
+        if (g_stop_signal != 0) {
+            stop_children(g_stop_signal);
+            break;
+        }
+        int status = 0;
+        auto pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        auto iter = std::find(_m_pids.begin(), _m_pids.end(), static_cast<int>(pid));
+        if (iter == _m_pids.end()) {
+            continue;
+        }
+        auto index = static_cast<int>(iter - _m_pids.begin());
+        *iter = 0;
+        running_nums--;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            continue;
+        }
+
+        // crashed or failed, keep a child from dying in a tight fork loop
+        auto lifetime_ms = now_ms() - _m_fork_ms[index];
+        if (lifetime_ms < _m_restart_delay_ms) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(_m_restart_delay_ms - lifetime_ms));
+        }
+        if (g_stop_signal != 0) {
+            continue;
+        }
+        pid = fork_child(index);
+        if (pid == 0) {
+            restore_actions();
+            process_index = index;
+            return true;
+        }
+        if (pid < 0) {
+            _m_failed = true;
+            stop_children(SIGTERM);
+            break;
+        }
+        _m_restart_nums++;
+        running_nums++;
+    }
+    restore_actions();
+    return false;
+#else
+    _m_failed = true;
+    return false;
+#endif
+}
+
+/***
+ *
+ * @param index
+ * @return
+ */
+int ProcessSupervisor::fork_child(int index) {
+#ifndef _WIN32
+    auto parent_pid = getpid();
+    auto pid = fork();
+    if (pid == 0) {
+#ifdef __linux__
+        // children do not outlive the supervisor
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent_pid) {
+            _exit(1);
+        }
+#endif
+        return 0;
+    }
+    if (pid > 0) {
+        _m_pids[index] = static_cast<int>(pid);
+        _m_fork_ms[index] = now_ms();
+    }
+    return static_cast<int>(pid);
+#else
+    return -1;
+#endif
+}
+
+/***
+ *
+ * @param sig
+ */
+void ProcessSupervisor::stop_children(int sig) {
+#ifndef _WIN32
+    for (auto pid : _m_pids) {
+        if (pid > 0) {
+            kill(pid, sig);
+        }
+    }
+    for (auto& pid : _m_pids) {
+        if (pid <= 0) {
+            continue;
+        }
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        pid = 0;
+    }
+#endif
+}
+
+}
+}
@@ -0,0 +1,99 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: process_supervisor.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_PROCESS_SUPERVISOR_H
+#define MM_AI_SERVER_PROCESS_SUPERVISOR_H
+
+#include <vector>
+
+namespace jinq {
+namespace common {
+/***
+ * Fork a fixed number of child processes from the calling one and supervise them. Children start
+ * from the state of the caller at fork time, memory loaded before is shared copy-on-write. A child
+ * exiting with status 0 is done, a crashed or failed one is forked again. SIGTERM, SIGINT and
+ * SIGHUP received by the parent are forwarded to the children.
+ * Fork from a process without running threads only, since children inherit no threads
+ */
+class ProcessSupervisor {
+public:
+    /***
+     * constructor
+     * @param process_nums
+     * @param restart_delay_ms : min lifetime of a child before it is restarted at once, children
+     *                           dying faster are restarted after the rest of it
+     */
+    explicit ProcessSupervisor(int process_nums, int restart_delay_ms = 1000);
+
+    /***
+     *
+     */
+    ~ProcessSupervisor() = default;
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    ProcessSupervisor(const ProcessSupervisor& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    ProcessSupervisor& operator=(const ProcessSupervisor& transformer) = delete;
+
+    /***
+     * fork children and supervise them
+     * @param process_index : index of the child in [0, process_nums), set in child only
+     * @return true in a child, false in parent once all children are gone or fork failed
+     */
+    bool run(int& process_index);
+
+    /***
+     * children forked again after crashing or failing
+     * @return
+     */
+    int restart_nums() const {
+        return _m_restart_nums;
+    }
+
+    /***
+     *
+     * @return
+     */
+    bool is_failed() const {
+        return _m_failed;
+    }
+
+private:
+    /***
+     *
+     * @param index
+     * @return pid of child, 0 in child, -1 if fork failed
+     */
+    int fork_child(int index);
+
+    /***
+     * forward signal to all running children and wait for them
+     * @param sig
+     */
+    void stop_children(int sig);
+
+private:
+    int _m_process_nums = 1;
+    int _m_restart_delay_ms = 1000;
+    int _m_restart_nums = 0;
+    bool _m_failed = false;
+    // pid and fork time of each child, pid 0 means not running
+    std::vector<int> _m_pids;
+    std::vector<long long> _m_fork_ms;
+};
+}
+}
+
+#endif //MM_AI_SERVER_PROCESS_SUPERVISOR_H
@@ -0,0 +1,119 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: result_cache.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "result_cache.h"
+
+#include <iterator>
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param max_bytes
+ * @param ttl_ms
+ */
+ResultCache::ResultCache(size_t max_bytes, int64_t ttl_ms)
+    : _m_max_bytes(max_bytes)
+    , _m_ttl_ms(ttl_ms) {
+}
+
+/***
+ *
+ * @param key
+ * @param value
+ * @return
+ */
+bool ResultCache::get(uint64_t key, std::string& value) {
+    std::lock_guard<std::mutex> lock(_m_mutex);
+
+    auto it = _m_entries.find(key);
+    if (it == _m_entries.end()) {
+        _m_misses++;
+        return false;
+    }
+    if (_m_ttl_ms > 0 && clock_type::now() >= it->second->expire_ts) {
+        erase(it->second);
+        _m_misses++;
+        return false;
+    }
+
+    _m_lru_list.splice(_m_lru_list.begin(), _m_lru_list, it->second);
+    value = it->second->value;
+    _m_hits++;
+    return true;
+}
+
+/***
+ *
+ * @param key
+ * @param value
+ */
+void ResultCache::put(uint64_t key, const std::string& value) {
+    cache_entry entry{key, value, clock_type::time_point::max()};
+    if (_m_ttl_ms > 0) {
+        entry.expire_ts = clock_type::now() + std::chrono::milliseconds(_m_ttl_ms);
+    }
+    auto new_entry_bytes = entry_bytes(entry);
+    if (new_entry_bytes > _m_max_bytes) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_m_mutex);
+    auto it = _m_entries.find(key);
+    if (it != _m_entries.end()) {
+        erase(it->second);
+    }
+    while (!_m_lru_list.empty() && _m_bytes + new_entry_bytes > _m_max_bytes) {
+        erase(std::prev(_m_lru_list.end()));
+    }
+
+    _m_lru_list.push_front(std::move(entry));
+    _m_entries[key] = _m_lru_list.begin();
+    _m_bytes += new_entry_bytes;
+}
+
+/***
+ *
+ * @return
+ */
+size_t ResultCache::size() const {
+    std::lock_guard<std::mutex> lock(_m_mutex);
+    return _m_entries.size();
+}
+
+/***
+ *
+ * @return
+ */
+size_t ResultCache::bytes() const {
+    std::lock_guard<std::mutex> lock(_m_mutex);
+    return _m_bytes;
+}
+
+/***
+ *
+ * @param entry
+ * @return
+ */
+size_t ResultCache::entry_bytes(const cache_entry& entry) {
+    // count list node and hash node overhead roughly
+    return entry.value.size() + sizeof(cache_entry) + 4 * sizeof(void*);
+}
+
+/***
+ *
+ * @param it
+ */
+void ResultCache::erase(std::list<cache_entry>::iterator it) {
+    _m_bytes -= entry_bytes(*it);
+    _m_entries.erase(it->key);
+    _m_lru_list.erase(it);
+}
+
+}
+}
@@ -0,0 +1,126 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: result_cache.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_RESULT_CACHE_H
+#define MM_AI_SERVER_RESULT_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace jinq {
+namespace common {
+class ResultCache {
+public:
+    /***
+     * constructor
+     * @param max_bytes: memory budget of cached values
+     * @param ttl_ms: entry expire time, non-positive means never expire
+     */
+    ResultCache(size_t max_bytes, int64_t ttl_ms);
+
+    /***
+     *
+     */
+    ~ResultCache() = default;
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    ResultCache(const ResultCache& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    ResultCache& operator=(const ResultCache& transformer) = delete;
+
+    /***
+     * fetch cached value and mark it as most recently used
+     * @param key
+     * @param value
+     * @return false if missing or expired
+     */
+    bool get(uint64_t key, std::string& value);
+
+    /***
+     * insert or update value, least recently used entries are evicted to keep memory budget
+     * @param key
+     * @param value
+     */
+    void put(uint64_t key, const std::string& value);
+
+    /***
+     *
+     * @return
+     */
+    size_t size() const;
+
+    /***
+     *
+     * @return
+     */
+    size_t bytes() const;
+
+    /***
+     *
+     * @return
+     */
+    uint64_t hits() const {
+        return _m_hits;
+    }
+
+    /***
+     *
+     * @return
+     */
+    uint64_t misses() const {
+        return _m_misses;
+    }
+
+private:
+    using clock_type = std::chrono::steady_clock;
+
+    struct cache_entry {
+        uint64_t key;
+        std::string value;
+        clock_type::time_point expire_ts;
+    };
+
+    /***
+     *
+     * @param entry
+     * @return
+     */
+    static size_t entry_bytes(const cache_entry& entry);
+
+    /***
+     *
+     * @param it
+     */
+    void erase(std::list<cache_entry>::iterator it);
+
+private:
+    size_t _m_max_bytes = 0;
+    int64_t _m_ttl_ms = 0;
+    size_t _m_bytes = 0;
+    // most recently used entry at front
+    std::list<cache_entry> _m_lru_list;
+    std::unordered_map<uint64_t, std::list<cache_entry>::iterator> _m_entries;
+    mutable std::mutex _m_mutex;
+    std::atomic<uint64_t> _m_hits{0};
+    std::atomic<uint64_t> _m_misses{0};
+};
+}
+}
+
+#endif //MM_AI_SERVER_RESULT_CACHE_H
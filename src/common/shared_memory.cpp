@@ -0,0 +1,82 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: shared_memory.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "shared_memory.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ */
+SharedMemoryRegion::~SharedMemoryRegion() {
+    close();
+}
+
+/***
+ *
+ * @param name
+ * @param offset
+ * @param size
+ * @return
+ */
+bool SharedMemoryRegion::open(const std::string& name, size_t offset, size_t size) {
+#ifndef _WIN32
+    close();
+    if (name.empty() || size == 0 || offset + size < offset) {
+        return false;
+    }
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < offset + size) {
+        ::close(fd);
+        return false;
+    }
+    // mmap offset must be page aligned, map from segment start instead
+    void* mapping = mmap(nullptr, offset + size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    _m_mapping = mapping;
+    _m_mapping_size = offset + size;
+    _m_data = static_cast<const char*>(mapping) + offset;
+    _m_size = size;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/***
+ *
+ */
+void SharedMemoryRegion::close() {
+#ifndef _WIN32
+    if (_m_mapping != nullptr) {
+        munmap(_m_mapping, _m_mapping_size);
+    }
+#endif
+    _m_mapping = nullptr;
+    _m_mapping_size = 0;
+    _m_data = nullptr;
+    _m_size = 0;
+}
+}
+}
@@ -0,0 +1,83 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: shared_memory.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_SHARED_MEMORY_H
+#define MM_AI_SERVER_SHARED_MEMORY_H
+
+#include <string>
+
+namespace jinq {
+namespace common {
+/***
+ * read only view of a region inside a posix shared memory segment owned by a co-located client,
+ * the segment stays mapped until the view is destroyed
+ */
+class SharedMemoryRegion {
+public:
+    /***
+     * constructor
+     */
+    SharedMemoryRegion() = default;
+
+    /***
+     *
+     */
+    ~SharedMemoryRegion();
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    SharedMemoryRegion(const SharedMemoryRegion& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    SharedMemoryRegion& operator=(const SharedMemoryRegion& transformer) = delete;
+
+    /***
+     * map [offset, offset + size) of shared memory segment
+     * @param name: segment name passed to shm_open, e.g. "/frame_0"
+     * @param offset
+     * @param size
+     * @return false if segment is missing or smaller than the region
+     */
+    bool open(const std::string& name, size_t offset, size_t size);
+
+    /***
+     *
+     */
+    void close();
+
+    /***
+     *
+     * @return
+     */
+    const char* data() const {
+        return _m_data;
+    }
+
+    /***
+     *
+     * @return
+     */
+    size_t size() const {
+        return _m_size;
+    }
+
+private:
+    void* _m_mapping = nullptr;
+    size_t _m_mapping_size = 0;
+    const char* _m_data = nullptr;
+    size_t _m_size = 0;
+};
+}
+}
+
+#endif //MM_AI_SERVER_SHARED_MEMORY_H
@@ -0,0 +1,308 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: slow_request_sampler.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "slow_request_sampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace jinq {
+namespace common {
+
+namespace {
+
+// capture files are written in host byte order, replay them on a host of same endianness
+const char CAPTURE_MAGIC[4] = {'M', 'S', 'L', 'W'};
+const uint32_t CAPTURE_VERSION = 1;
+// refuse to allocate for a corrupted length field
+const uint32_t MAX_FIELD_BYTES = 256U * 1024U * 1024U;
+
+/***
+ *
+ * @return
+ */
+int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/***
+ * min heap on total ms, the fastest kept request is on top
+ * @param lhs
+ * @param rhs
+ * @return
+ */
+bool slower_than(const slow_request_record& lhs, const slow_request_record& rhs) {
+    return lhs.total_ms > rhs.total_ms;
+}
+
+/***
+ *
+ * @tparam T
+ * @param out
+ * @param value
+ */
+template<typename T>
+void write_pod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/***
+ *
+ * @param out
+ * @param value
+ */
+void write_string(std::ofstream& out, const std::string& value) {
+    write_pod(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+/***
+ *
+ * @tparam T
+ * @param in
+ * @param value
+ * @return
+ */
+template<typename T>
+bool read_pod(std::ifstream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+/***
+ *
+ * @param in
+ * @param value
+ * @return
+ */
+bool read_string(std::ifstream& in, std::string& value) {
+    uint32_t size = 0;
+    if (!read_pod(in, size) || size > MAX_FIELD_BYTES) {
+        return false;
+    }
+    value.resize(size);
+    if (size == 0) {
+        return true;
+    }
+    in.read(&value[0], size);
+    return static_cast<bool>(in);
+}
+}
+
+/***
+ *
+ * @param file_prefix
+ * @param keep_nums
+ * @param window_ms
+ * @param file_nums
+ */
+SlowRequestSampler::SlowRequestSampler(std::string file_prefix, size_t keep_nums, int64_t window_ms, size_t file_nums)
+    : _m_file_prefix(std::move(file_prefix))
+    , _m_keep_nums(std::max<size_t>(1, keep_nums))
+    , _m_window_ms(std::max<int64_t>(1, window_ms))
+    , _m_file_nums(std::max<size_t>(1, file_nums)) {
+    _m_records.reserve(_m_keep_nums);
+}
+
+/***
+ *
+ */
+SlowRequestSampler::~SlowRequestSampler() {
+    flush();
+}
+
+/***
+ *
+ * @param total_ms
+ * @return
+ */
+bool SlowRequestSampler::would_keep(double total_ms) const {
+    // a finished window has to be written out by the next offer whatever its total ms is
+    if (steady_now_ms() >= _m_window_end_ms.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return total_ms > _m_threshold_ms.load(std::memory_order_relaxed);
+}
+
+/***
+ *
+ * @param record
+ */
+void SlowRequestSampler::offer(slow_request_record record) {
+    std::vector<slow_request_record> finished_records;
+    std::string finished_path;
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        auto now = steady_now_ms();
+        if (now >= _m_window_end_ms.load(std::memory_order_relaxed)) {
+            finished_path = roll_window(now, finished_records);
+        }
+
+        if (_m_records.size() < _m_keep_nums) {
+            _m_records.push_back(std::move(record));
+            std::push_heap(_m_records.begin(), _m_records.end(), slower_than);
+        } else if (record.total_ms > _m_records.front().total_ms) {
+            std::pop_heap(_m_records.begin(), _m_records.end(), slower_than);
+            _m_records.back() = std::move(record);
+            std::push_heap(_m_records.begin(), _m_records.end(), slower_than);
+        }
+        update_threshold();
+    }
+
+    // disk io stays out of the lock, requests of next window are not blocked by it
+    if (!finished_records.empty()) {
+        write(finished_path, finished_records);
+    }
+}
+
+/***
+ *
+ * @return
+ */
+bool SlowRequestSampler::flush() {
+    std::vector<slow_request_record> finished_records;
+    std::string finished_path;
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        finished_path = roll_window(steady_now_ms(), finished_records);
+    }
+    if (finished_records.empty()) {
+        return true;
+    }
+    return write(finished_path, finished_records);
+}
+
+/***
+ *
+ * @param path
+ * @param records
+ * @return
+ */
+bool SlowRequestSampler::load(const std::string& path, std::vector<slow_request_record>& records) {
+    records.clear();
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    char magic[4] = {0};
+    uint32_t version = 0;
+    uint32_t record_nums = 0;
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0) {
+        return false;
+    }
+    if (!read_pod(in, version) || version != CAPTURE_VERSION || !read_pod(in, record_nums)) {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < record_nums; ++idx) {
+        slow_request_record record;
+        uint32_t stage_nums = 0;
+        bool ok = read_string(in, record.server_uri) && read_string(in, record.task_id) &&
+                  read_pod(in, record.finished_ts_ms) && read_pod(in, record.status) &&
+                  read_pod(in, record.worker_id) && read_pod(in, record.total_ms) &&
+                  read_pod(in, stage_nums) && stage_nums <= 64;
+        for (uint32_t stage_idx = 0; ok && stage_idx < stage_nums; ++stage_idx) {
+            std::pair<std::string, double> stage;
+            ok = read_string(in, stage.first) && read_pod(in, stage.second);
+            record.stage_ms.push_back(std::move(stage));
+        }
+        ok = ok && read_pod(in, record.raw_width) && read_pod(in, record.raw_height) &&
+             read_pod(in, record.raw_channels) && read_string(in, record.image_data);
+        if (!ok) {
+            records.clear();
+            return false;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+/***
+ *
+ * @param path
+ * @param records
+ * @return
+ */
+bool SlowRequestSampler::write(const std::string& path, std::vector<slow_request_record>& records) {
+    std::sort(records.begin(), records.end(), slower_than);
+
+    // readers never see a half written capture file
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+        write_pod(out, CAPTURE_VERSION);
+        write_pod(out, static_cast<uint32_t>(records.size()));
+        for (const auto& record : records) {
+            write_string(out, record.server_uri);
+            write_string(out, record.task_id);
+            write_pod(out, record.finished_ts_ms);
+            write_pod(out, record.status);
+            write_pod(out, record.worker_id);
+            write_pod(out, record.total_ms);
+            write_pod(out, static_cast<uint32_t>(record.stage_ms.size()));
+            for (const auto& stage : record.stage_ms) {
+                write_string(out, stage.first);
+                write_pod(out, stage.second);
+            }
+            write_pod(out, record.raw_width);
+            write_pod(out, record.raw_height);
+            write_pod(out, record.raw_channels);
+            write_string(out, record.image_data);
+        }
+        out.flush();
+        if (!out) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***
+ *
+ * @param now_ms
+ * @param records
+ * @return
+ */
+std::string SlowRequestSampler::roll_window(int64_t now_ms, std::vector<slow_request_record>& records) {
+    _m_window_end_ms.store(now_ms + _m_window_ms, std::memory_order_relaxed);
+    if (_m_records.empty()) {
+        return "";
+    }
+    auto path = file_path(_m_window_seq % _m_file_nums);
+    _m_window_seq++;
+    records.swap(_m_records);
+    _m_records.clear();
+    _m_records.reserve(_m_keep_nums);
+    update_threshold();
+    return path;
+}
+
+/***
+ *
+ */
+void SlowRequestSampler::update_threshold() {
+    auto threshold = _m_records.size() < _m_keep_nums ? 0.0 : _m_records.front().total_ms;
+    _m_threshold_ms.store(threshold, std::memory_order_relaxed);
+}
+
+}
+}
@@ -0,0 +1,159 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: slow_request_sampler.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_SLOW_REQUEST_SAMPLER_H
+#define MM_AI_SERVER_SLOW_REQUEST_SAMPLER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jinq {
+namespace common {
+
+/***
+ * one captured request, enough to feed the same input to the model again
+ */
+struct slow_request_record {
+    std::string server_uri;
+    std::string task_id;
+    // wall clock ms when request finished
+    int64_t finished_ts_ms = 0;
+    int32_t status = 0;
+    // model worker which ran the request, -1 if it never held one
+    int32_t worker_id = -1;
+    double total_ms = 0;
+    // serving stage name and its elapse in ms
+    std::vector<std::pair<std::string, double>> stage_ms;
+    // non-zero for raw uint8 pixels, zero for encoded image bytes
+    int32_t raw_width = 0;
+    int32_t raw_height = 0;
+    int32_t raw_channels = 0;
+    std::string image_data;
+};
+
+/***
+ * Keep the slowest requests of each time window and write them into a ring of capture files once
+ * the window is over, file index of a window is its sequence modulo file nums
+ */
+class SlowRequestSampler {
+public:
+    /***
+     * constructor
+     * @param file_prefix : capture files are named file_prefix.<index>.bin
+     * @param keep_nums : slowest requests kept per window
+     * @param window_ms
+     * @param file_nums
+     */
+    SlowRequestSampler(std::string file_prefix, size_t keep_nums, int64_t window_ms, size_t file_nums);
+
+    /***
+     * write requests of current window
+     */
+    ~SlowRequestSampler();
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    SlowRequestSampler(const SlowRequestSampler& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    SlowRequestSampler& operator=(const SlowRequestSampler& transformer) = delete;
+
+    /***
+     * cheap check before building a record, false if request is faster than all kept ones
+     * @param total_ms
+     * @return
+     */
+    bool would_keep(double total_ms) const;
+
+    /***
+     * keep record if it is among the slowest of current window, requests of a finished window
+     * are written to its capture file first
+     * @param record
+     */
+    void offer(slow_request_record record);
+
+    /***
+     * write requests of current window now and start a new one
+     * @return false if capture file can not be written
+     */
+    bool flush();
+
+    /***
+     *
+     * @param index
+     * @return
+     */
+    std::string file_path(size_t index) const {
+        return _m_file_prefix + "." + std::to_string(index) + ".bin";
+    }
+
+    /***
+     * windows written into capture files
+     * @return
+     */
+    size_t written_windows() const {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        return _m_window_seq;
+    }
+
+    /***
+     * read records of one capture file, slowest first
+     * @param path
+     * @param records
+     * @return false if file is missing or corrupted
+     */
+    static bool load(const std::string& path, std::vector<slow_request_record>& records);
+
+private:
+    /***
+     *
+     * @param path
+     * @param records
+     * @return
+     */
+    static bool write(const std::string& path, std::vector<slow_request_record>& records);
+
+    /***
+     * take records of current window and start next window, caller holds the lock
+     * @param now_ms
+     * @param records
+     * @return capture file path of taken window
+     */
+    std::string roll_window(int64_t now_ms, std::vector<slow_request_record>& records);
+
+    /***
+     * lowest total ms of kept records, 0 while fewer than keep nums are kept. caller holds the lock
+     */
+    void update_threshold();
+
+private:
+    std::string _m_file_prefix;
+    size_t _m_keep_nums = 10;
+    int64_t _m_window_ms = 60000;
+    size_t _m_file_nums = 10;
+
+    mutable std::mutex _m_mutex;
+    // min heap of total ms
+    std::vector<slow_request_record> _m_records;
+    size_t _m_window_seq = 0;
+    std::atomic<int64_t> _m_window_end_ms{0};
+    std::atomic<double> _m_threshold_ms{0};
+};
+}
+}
+
+#endif //MM_AI_SERVER_SLOW_REQUEST_SAMPLER_H
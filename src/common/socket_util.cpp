@@ -0,0 +1,99 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: socket_util.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "socket_util.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+namespace jinq {
+namespace common {
+namespace socket_util {
+
+/***
+ *
+ * @param fd
+ * @return
+ */
+bool is_peer_closed(int fd) {
+#ifndef _WIN32
+    if (fd < 0) {
+        return false;
+    }
+    // a client which closed its socket only sent FIN, which is reported as POLLRDHUP rather than POLLHUP
+    struct pollfd pfd{};
+    pfd.fd = fd;
+    pfd.events = POLLRDHUP;
+    if (poll(&pfd, 1, 0) <= 0) {
+        return false;
+    }
+    return (pfd.revents & (POLLRDHUP | POLLHUP | POLLERR)) != 0;
+#else
+    return false;
+#endif
+}
+
+/***
+ *
+ * @param fd
+ * @return
+ */
+bool is_local_peer(int fd) {
+#ifndef _WIN32
+    if (fd < 0) {
+        return false;
+    }
+    struct sockaddr_storage addr{};
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+        return false;
+    }
+    return addr.ss_family == AF_UNIX;
+#else
+    return false;
+#endif
+}
+
+/***
+ *
+ * @param fd
+ * @return
+ */
+bool is_loopback_peer(int fd) {
+#ifndef _WIN32
+    if (fd < 0) {
+        return false;
+    }
+    struct sockaddr_storage addr{};
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(fd, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+        return false;
+    }
+    if (addr.ss_family == AF_INET) {
+        auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&addr);
+        return (ntohl(addr4->sin_addr.s_addr) >> 24) == 127;
+    }
+    if (addr.ss_family == AF_INET6) {
+        auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
+        if (IN6_IS_ADDR_V4MAPPED(&addr6->sin6_addr)) {
+            return addr6->sin6_addr.s6_addr[12] == 127;
+        }
+        return IN6_IS_ADDR_LOOPBACK(&addr6->sin6_addr);
+    }
+    return false;
+#else
+    return false;
+#endif
+}
+
+}
+}
+}
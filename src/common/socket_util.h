@@ -0,0 +1,41 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: socket_util.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_SOCKET_UTIL_H
+#define MM_AI_SERVER_SOCKET_UTIL_H
+
+namespace jinq {
+namespace common {
+namespace socket_util {
+
+/***
+ * poll the accepted socket without consuming data. End of stream, hang up or error means the client is gone,
+ * http clients do not half close a connection while waiting for the response
+ * @param fd
+ * @return
+ */
+bool is_peer_closed(int fd);
+
+/***
+ * whether the socket was accepted on a unix domain socket, i.e. the client runs on this host
+ * @param fd
+ * @return
+ */
+bool is_local_peer(int fd);
+
+/***
+ * whether the tcp client of the socket connected from loopback address
+ * @param fd
+ * @return
+ */
+bool is_loopback_peer(int fd);
+
+}
+}
+}
+
+#endif //MM_AI_SERVER_SOCKET_UTIL_H
@@ -0,0 +1,79 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: stage_thread_pool.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "stage_thread_pool.h"
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param thread_nums
+ */
+StageThreadPool::StageThreadPool(size_t thread_nums) {
+    for (size_t index = 0; index < thread_nums; ++index) {
+        _m_threads.emplace_back(&StageThreadPool::run_loop, this);
+    }
+}
+
+/***
+ *
+ */
+StageThreadPool::~StageThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        _m_stopped = true;
+    }
+    _m_cv.notify_all();
+    for (auto& thread : _m_threads) {
+        thread.join();
+    }
+}
+
+/***
+ *
+ * @param job
+ * @param deadline
+ */
+void StageThreadPool::submit(std::function<void()> job, const time_point& deadline) {
+    {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        _m_jobs.push(stage_job{std::move(job), deadline, _m_seq++});
+    }
+    _m_cv.notify_one();
+}
+
+/***
+ *
+ * @return
+ */
+size_t StageThreadPool::queued_nums() const {
+    std::lock_guard<std::mutex> lock(_m_mutex);
+    return _m_jobs.size();
+}
+
+/***
+ *
+ */
+void StageThreadPool::run_loop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_m_mutex);
+            _m_cv.wait(lock, [this] { return _m_stopped || !_m_jobs.empty(); });
+            if (_m_jobs.empty()) {
+                return;
+            }
+            job = std::move(const_cast<stage_job&>(_m_jobs.top()).job);
+            _m_jobs.pop();
+        }
+        job();
+    }
+}
+
+}
+}
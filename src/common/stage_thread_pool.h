@@ -0,0 +1,107 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: stage_thread_pool.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_STAGE_THREAD_POOL_H
+#define MM_AI_SERVER_STAGE_THREAD_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace jinq {
+namespace common {
+/***
+ * Fixed size thread pool running one pipeline stage. Jobs are run earliest deadline first,
+ * jobs without deadline are run in submission order after them
+ */
+class StageThreadPool {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+
+    /***
+     * constructor
+     * @param thread_nums
+     */
+    explicit StageThreadPool(size_t thread_nums);
+
+    /***
+     * wait for queued jobs to finish and join threads
+     */
+    ~StageThreadPool();
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    StageThreadPool(const StageThreadPool& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    StageThreadPool& operator=(const StageThreadPool& transformer) = delete;
+
+    /***
+     *
+     * @param job
+     * @param deadline
+     */
+    void submit(std::function<void()> job, const time_point& deadline = time_point::max());
+
+    /***
+     *
+     * @return
+     */
+    size_t thread_nums() const {
+        return _m_threads.size();
+    }
+
+    /***
+     * queued jobs not started yet
+     * @return
+     */
+    size_t queued_nums() const;
+
+private:
+    struct stage_job {
+        std::function<void()> job;
+        time_point deadline;
+        uint64_t seq;
+    };
+
+    struct later_job {
+        bool operator()(const stage_job& lhs, const stage_job& rhs) const {
+            if (lhs.deadline != rhs.deadline) {
+                return lhs.deadline > rhs.deadline;
+            }
+            return lhs.seq > rhs.seq;
+        }
+    };
+
+    /***
+     *
+     */
+    void run_loop();
+
+private:
+    mutable std::mutex _m_mutex;
+    std::condition_variable _m_cv;
+    std::priority_queue<stage_job, std::vector<stage_job>, later_job> _m_jobs;
+    std::vector<std::thread> _m_threads;
+    uint64_t _m_seq = 0;
+    bool _m_stopped = false;
+};
+}
+}
+
+#endif //MM_AI_SERVER_STAGE_THREAD_POOL_H
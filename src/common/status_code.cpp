@@ -21,11 +21,15 @@ std::map<int, std::string>& get_error_code_table() {
 
         { StatusCode::MODEL_INIT_FAILED, "model init failed" },
         { StatusCode::MODEL_RUN_TIMEOUT, "model run timeout" },
+        { StatusCode::MODEL_RUN_DEADLINE_EXCEEDED, "model run deadline exceeded" },
+        { StatusCode::MODEL_RUN_CANCELLED, "model run cancelled" },
         { StatusCode::MODEL_EMPTY_INPUT_IMAGE, "model input empty" },
         { StatusCode::MODEL_RUN_SESSION_FAILED, "model run session failed" },
 
         { StatusCode::SERVER_INIT_FAILED, "server init failed" },
         { StatusCode::SERVER_RUN_FAILED, "server run failed" },
+        { StatusCode::SERVER_OVERLOADED, "server overloaded" },
+        { StatusCode::SERVER_RATE_LIMITED, "server rate limited" },
 
         { StatusCode::FILE_READ_ERROR, "file read error" },
         { StatusCode::FILE_WRITE_ERROR, "file write error" },
@@ -21,10 +21,14 @@ enum StatusCode {
     MODEL_RUN_SESSION_FAILED = 2,
     MODEL_EMPTY_INPUT_IMAGE = 3,
     MODEL_RUN_TIMEOUT = 4,
+    MODEL_RUN_DEADLINE_EXCEEDED = 5,
+    MODEL_RUN_CANCELLED = 6,
 
     // server status
     SERVER_INIT_FAILED = 11,
     SERVER_RUN_FAILED = 12,
+    SERVER_OVERLOADED = 13,
+    SERVER_RATE_LIMITED = 14,
 
     // file status
     FILE_READ_ERROR = 30,
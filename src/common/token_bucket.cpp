@@ -0,0 +1,53 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: token_bucket.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "token_bucket.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace jinq {
+namespace common {
+
+/***
+ *
+ * @param rate
+ * @param burst
+ */
+TokenBucket::TokenBucket(double rate, double burst)
+    : _m_rate(rate)
+    , _m_burst(std::max(burst, 1.0))
+    , _m_tokens(_m_burst)
+    , _m_last_refill_ts(clock_type::now()) {
+}
+
+/***
+ *
+ * @param retry_after_ms
+ * @param tokens
+ * @return
+ */
+bool TokenBucket::try_acquire(int64_t* retry_after_ms, size_t tokens) {
+    std::lock_guard<std::mutex> lock(_m_mutex);
+
+    auto now = clock_type::now();
+    double elapse_s = std::chrono::duration<double>(now - _m_last_refill_ts).count();
+    _m_tokens = std::min(_m_burst, _m_tokens + elapse_s * _m_rate);
+    _m_last_refill_ts = now;
+
+    auto required = std::min(_m_burst, static_cast<double>(tokens));
+    if (_m_tokens >= required) {
+        _m_tokens -= static_cast<double>(tokens);
+        return true;
+    }
+    if (retry_after_ms != nullptr) {
+        *retry_after_ms = _m_rate > 0.0 ? static_cast<int64_t>(std::ceil((required - _m_tokens) / _m_rate * 1000)) : -1;
+    }
+    return false;
+}
+}
+}
@@ -0,0 +1,82 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: token_bucket.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_TOKEN_BUCKET_H
+#define MM_AI_SERVER_TOKEN_BUCKET_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace jinq {
+namespace common {
+class TokenBucket {
+public:
+    /***
+     * constructor
+     * @param rate: tokens refilled per second
+     * @param burst: bucket capacity, bucket starts full
+     */
+    TokenBucket(double rate, double burst);
+
+    /***
+     *
+     */
+    ~TokenBucket() = default;
+
+    /***
+     * constructor
+     * @param transformer
+     */
+    TokenBucket(const TokenBucket& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    TokenBucket& operator=(const TokenBucket& transformer) = delete;
+
+    /***
+     * take tokens without blocking. More tokens than burst are granted once the bucket is full and are
+     * paid back by later refills, so the long term rate still holds
+     * @param retry_after_ms: milliseconds until enough tokens are available if failed, may be null
+     * @param tokens
+     * @return false if bucket has not enough tokens
+     */
+    bool try_acquire(int64_t* retry_after_ms = nullptr, size_t tokens = 1);
+
+    /***
+     *
+     * @return
+     */
+    double rate() const {
+        return _m_rate;
+    }
+
+    /***
+     *
+     * @return
+     */
+    double burst() const {
+        return _m_burst;
+    }
+
+private:
+    using clock_type = std::chrono::steady_clock;
+
+    double _m_rate = 0.0;
+    double _m_burst = 0.0;
+    double _m_tokens = 0.0;
+    clock_type::time_point _m_last_refill_ts;
+    std::mutex _m_mutex;
+};
+}
+}
+
+#endif //MM_AI_SERVER_TOKEN_BUCKET_H
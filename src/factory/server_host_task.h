@@ -0,0 +1,83 @@
+/************************************************
+ * Copyright MaybeShewill-CV. All Rights Reserved.
+ * Author: MaybeShewill-CV
+ * File: server_host_task.h
+ * Date: 26-10-16
+ ************************************************/
+
+#ifndef MM_AI_SERVER_SERVER_HOST_TASK_H
+#define MM_AI_SERVER_SERVER_HOST_TASK_H
+
+#include <functional>
+#include <map>
+
+#include "factory/base_factory.h"
+#include "factory/register_marco.h"
+#include "factory/classification_task.h"
+#include "factory/enhancement_task.h"
+#include "factory/feature_point_task.h"
+#include "factory/matting_task.h"
+#include "factory/obj_detection_task.h"
+#include "factory/ocr_task.h"
+#include "factory/scene_segmentation_task.h"
+#include "server/host/model_server_host.h"
+
+namespace jinq {
+namespace factory {
+
+using jinq::server::BaseAiServer;
+
+namespace host {
+using jinq::server::host::ModelServerHost;
+
+/***
+ * create model server host instance
+ * @param server_name
+ * @return
+ */
+static std::unique_ptr<BaseAiServer> create_model_server_host(const std::string& server_name) {
+    REGISTER_AI_SERVER(ModelServerHost, server_name)
+    return ServerFactory<BaseAiServer>::get_instance().get_server(server_name);
+}
+
+/***
+ * create model server according to the server section name of its config
+ * @param server_section_name: e.g. YOLOV5_DETECTION_SERVER
+ * @param server_name
+ * @return nullptr if no model server uses this section name
+ */
+static std::unique_ptr<BaseAiServer> create_hosted_server(
+    const std::string& server_section_name, const std::string& server_name) {
+    static const std::map<std::string, std::function<std::unique_ptr<BaseAiServer>(const std::string&)> > creators = {
+        {"DENSENET_CLASSIFICATION_SERVER", classification::create_densenet_cls_server},
+        {"MOBILENETV2_CLASSIFICATION_SERVER", classification::create_mobilenetv2_cls_server},
+        {"RESNET_CLASSIFICATION_SERVER", classification::create_resnet_cls_server},
+        {"ATTENTIVE_GAN_DERAIN_SERVER", enhancement::create_attentivegan_derain_server},
+        {"ENLIGHTEN_GAN_SERVER", enhancement::create_enlightengan_server},
+        {"REAL_ESRGAN_SERVER", enhancement::create_realesrgan_server},
+        {"SUPERPOINT_FP_SERVER", feature_point::create_superpoint_fp_server},
+        {"MODNET_SERVER", matting::create_modnet_server},
+        {"PP_MATTING_SERVER", matting::create_pp_matting_server},
+        {"LIBFACE_DETECTION_SERVER", object_detection::create_libface_det_server},
+        {"NANODET_DETECTION_SERVER", object_detection::create_nanodet_det_server},
+        {"YOLOV5_DETECTION_SERVER", object_detection::create_yolov5_det_server},
+        {"YOLOV6_DETECTION_SERVER", object_detection::create_yolov6_det_server},
+        {"YOLOV7_DETECTION_SERVER", object_detection::create_yolov7_det_server},
+        {"DBNET_SERVER", ocr::create_dbtext_detection_server},
+        {"BISENETV2_SERVER", scene_segmentation::create_bisenetv2_server},
+        {"PPHUMAN_SEG_SERVER", scene_segmentation::create_pphuman_seg_server},
+    };
+
+    auto creator = creators.find(server_section_name);
+    if (creator == creators.end()) {
+        LOG(ERROR) << "No server uses section named: " << server_section_name;
+        return nullptr;
+    }
+    return creator->second(server_name);
+}
+
+} // namespace host
+} // namespace factory
+} // namespace jinq
+
+#endif // MM_AI_SERVER_SERVER_HOST_TASK_H
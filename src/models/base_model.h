@@ -8,6 +8,9 @@
 #ifndef MMAISERVER_BASE_MODEL_H
 #define MMAISERVER_BASE_MODEL_H
 
+#include <functional>
+#include <vector>
+
 #include "toml/toml.hpp"
 
 #include "common/status_code.h"
@@ -57,6 +60,38 @@ public:
      */
     virtual jinq::common::StatusCode run(const INPUT& in, OUTPUT& out) = 0;
 
+    /***
+     * run a batch of inputs with one model invocation. Models whose backend supports batched
+     * input tensors should override this, the default one runs the inputs one by one
+     * @param in
+     * @param out
+     * @return
+     */
+    virtual jinq::common::StatusCode run_batch(const std::vector<INPUT>& in, std::vector<OUTPUT>& out) {
+        out.resize(in.size());
+        for (size_t index = 0; index < in.size(); ++index) {
+            auto status = run(in[index], out[index]);
+            if (status != jinq::common::StatusCode::OK) {
+                return status;
+            }
+        }
+        return jinq::common::StatusCode::OK;
+    }
+
+    /***
+     * run input asynchronously. It returns once the model is ready to take the next input and no
+     * longer references the input, done is invoked with the output later, maybe on another thread.
+     * Models able to overlap post-process of one input with inference of the next should override
+     * this, the default one runs synchronously and invokes done before returning
+     * @param in
+     * @param done
+     */
+    virtual void run_async(const INPUT& in, std::function<void(jinq::common::StatusCode, OUTPUT&)> done) {
+        OUTPUT out;
+        auto status = run(in, out);
+        done(status, out);
+    }
+
     /***
      *
      * @return
@@ -63,6 +63,13 @@ public:
      */
     jinq::common::StatusCode run(const INPUT& input, OUTPUT& output) override;
 
+    /***
+     * decoding and nms of output run on the detector's post-process thread, so the session can
+     * take the next input meanwhile
+     * @param input
+     * @param done
+     */
+    void run_async(const INPUT& input, std::function<void(jinq::common::StatusCode, OUTPUT&)> done) override;
 
     /***
      * if yolov5t detector successfully initialized
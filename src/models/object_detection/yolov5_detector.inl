@@ -16,6 +16,7 @@
 #include "common/base64.h"
 #include "common/cv_utils.h"
 #include "common/file_path_util.h"
+#include "common/stage_thread_pool.h"
 
 namespace jinq {
 namespace models {
@@ -24,6 +25,7 @@ using jinq::common::FilePathUtil;
 using jinq::common::StatusCode;
 using jinq::common::Base64;
 using jinq::common::CvUtils;
+using jinq::common::StageThreadPool;
 using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::common_io::file_input;
 using jinq::models::io_define::common_io::base64_input;
@@ -130,6 +132,8 @@ public:
      *
      */
     ~Impl() {
+        // finish queued post-process before releasing the model
+        _m_postprocess_pool.reset();
         if (_m_net != nullptr && _m_session != nullptr) {
             _m_net->releaseModel();
             _m_net->releaseSession(_m_session);
@@ -164,6 +168,13 @@ public:
     */
     StatusCode run(const INPUT& in, OUTPUT& out);
 
+    /***
+    *
+    * @param in
+    * @param done
+    */
+    void run_async(const INPUT& in, std::function<void(StatusCode, OUTPUT&)> done);
+
     /***
      *
      * @return
@@ -199,6 +210,8 @@ public:
     cv::Size _m_input_size_host = cv::Size();
     // init flag
     bool _m_successfully_initialized = false;
+    // post-process of async runs, created on first async run
+    std::unique_ptr<StageThreadPool> _m_postprocess_pool;
 
 public:
     /***
@@ -212,6 +225,32 @@ public:
      * @return
      */
     yolov5_impl::internal_output decode_output_tensor() const;
+
+    /***
+     * copy output tensor to host
+     * @param output_data
+     * @param batch_nums
+     * @param bbox_nums
+     */
+    void fetch_output_tensor(std::vector<float>& output_data, int& batch_nums, int& bbox_nums) const;
+
+    /***
+     *
+     * @param output_data
+     * @param batch_nums
+     * @param bbox_nums
+     * @param input_size_user
+     * @return
+     */
+    yolov5_impl::internal_output decode_output_data(
+        const std::vector<float>& output_data, int batch_nums, int bbox_nums, const cv::Size& input_size_user) const;
+
+    /***
+     * nms and keep top k
+     * @param bbox_result
+     * @return
+     */
+    yolov5_impl::internal_output nms_output(const yolov5_impl::internal_output& bbox_result) const;
 };
 
 /***
@@ -418,35 +457,122 @@ StatusCode YoloV5Detector<INPUT, OUTPUT>::Impl::run(const INPUT& in, OUTPUT& out
     auto bbox_result = decode_output_tensor();
 
     // do nms
-    yolov5_impl::internal_output nms_result = CvUtils::nms_bboxes(bbox_result, _m_nms_threshold);
-    if (nms_result.size() > _m_keep_topk) {
-        nms_result.resize(_m_keep_topk);
-    }
+    auto nms_result = nms_output(bbox_result);
 
     // transform internal output into external output
     out = yolov5_impl::transform_output<OUTPUT>(nms_result);
     return StatusCode::OK;
 }
 
+/***
+*
+* @param in
+* @param done
+*/
+template<typename INPUT, typename OUTPUT>
+void YoloV5Detector<INPUT, OUTPUT>::Impl::run_async(const INPUT& in, std::function<void(StatusCode, OUTPUT&)> done) {
+    // transform external input into internal input
+    auto internal_in = yolov5_impl::transform_input(in);
+
+    if (!internal_in.input_image.data || internal_in.input_image.empty()) {
+        OUTPUT out;
+        done(StatusCode::MODEL_EMPTY_INPUT_IMAGE, out);
+        return;
+    }
+
+    // preprocess image
+    auto input_size_user = internal_in.input_image.size();
+    auto preprocessed_image = preprocess_image(internal_in.input_image);
+    auto input_chw_image_data = CvUtils::convert_to_chw_vec(preprocessed_image);
+
+    // run session
+    MNN::Tensor input_tensor_user(_m_input_tensor, MNN::Tensor::DimensionType::CAFFE);
+    auto input_tensor_data = input_tensor_user.host<float>();
+    auto input_tensor_size = input_tensor_user.size();
+    ::memcpy(input_tensor_data, input_chw_image_data.data(), input_tensor_size);
+    _m_input_tensor->copyFromHostTensor(&input_tensor_user);
+    _m_net->runSession(_m_session);
+
+    // output is copied out of the session before next input overwrites it
+    std::vector<float> output_data;
+    int batch_nums = 0;
+    int bbox_nums = 0;
+    fetch_output_tensor(output_data, batch_nums, bbox_nums);
+
+    if (_m_postprocess_pool == nullptr) {
+        _m_postprocess_pool = std::make_unique<StageThreadPool>(1);
+    }
+    _m_postprocess_pool->submit([this, output_data = std::move(output_data), batch_nums, bbox_nums,
+                                 input_size_user, done = std::move(done)]() {
+        auto bbox_result = decode_output_data(output_data, batch_nums, bbox_nums, input_size_user);
+        auto nms_result = nms_output(bbox_result);
+        auto out = yolov5_impl::transform_output<OUTPUT>(nms_result);
+        done(StatusCode::OK, out);
+    });
+}
+
+/***
+*
+* @param bbox_result
+* @return
+*/
+template<typename INPUT, typename OUTPUT>
+yolov5_impl::internal_output YoloV5Detector<INPUT, OUTPUT>::Impl::nms_output(
+    const yolov5_impl::internal_output& bbox_result) const {
+    yolov5_impl::internal_output nms_result = CvUtils::nms_bboxes(bbox_result, _m_nms_threshold);
+    if (nms_result.size() > _m_keep_topk) {
+        nms_result.resize(_m_keep_topk);
+    }
+    return nms_result;
+}
+
 /***
 *
 * @return
 */
 template<typename INPUT, typename OUTPUT>
 yolov5_impl::internal_output YoloV5Detector<INPUT, OUTPUT>::Impl::decode_output_tensor() const {
+    std::vector<float> output_tensordata;
+    int batch_nums = 0;
+    int raw_pred_bbox_nums = 0;
+    fetch_output_tensor(output_tensordata, batch_nums, raw_pred_bbox_nums);
+    return decode_output_data(output_tensordata, batch_nums, raw_pred_bbox_nums, _m_input_size_user);
+}
 
+/***
+*
+* @param output_data
+* @param batch_nums
+* @param bbox_nums
+*/
+template<typename INPUT, typename OUTPUT>
+void YoloV5Detector<INPUT, OUTPUT>::Impl::fetch_output_tensor(
+    std::vector<float>& output_data, int& batch_nums, int& bbox_nums) const {
     // convert tensor format
     MNN::Tensor output_tensor_user(_m_output_tensor, MNN::Tensor::DimensionType::CAFFE);
     _m_output_tensor->copyToHostTensor(&output_tensor_user);
 
     // fetch tensor data
-    std::vector<float> output_tensordata(output_tensor_user.elementSize());
-    ::memcpy(&output_tensordata[0], output_tensor_user.host<float>(),
+    output_data.resize(output_tensor_user.elementSize());
+    ::memcpy(&output_data[0], output_tensor_user.host<float>(),
              output_tensor_user.elementSize() * sizeof(float));
 
-    auto batch_nums = output_tensor_user.shape()[0];
-    auto raw_pred_bbox_nums = output_tensor_user.shape()[1];
+    batch_nums = output_tensor_user.shape()[0];
+    bbox_nums = output_tensor_user.shape()[1];
+}
 
+/***
+*
+* @param output_data
+* @param batch_nums
+* @param raw_pred_bbox_nums
+* @param input_size_user
+* @return
+*/
+template<typename INPUT, typename OUTPUT>
+yolov5_impl::internal_output YoloV5Detector<INPUT, OUTPUT>::Impl::decode_output_data(
+    const std::vector<float>& output_tensordata, int batch_nums, int raw_pred_bbox_nums,
+    const cv::Size& input_size_user) const {
     std::vector<std::vector<float> > raw_output;
     raw_output.resize(raw_pred_bbox_nums);
 
@@ -500,9 +626,9 @@ yolov5_impl::internal_output YoloV5Detector<INPUT, OUTPUT>::Impl::decode_output_
                 raw_bbox_info[0] + raw_bbox_info[2] / 2.0f,
                 raw_bbox_info[1] + raw_bbox_info[3] / 2.0f
             };
-            auto w_scale = static_cast<float>(_m_input_size_user.width) /
+            auto w_scale = static_cast<float>(input_size_user.width) /
                            static_cast<float>(_m_input_size_host.width);
-            auto h_scale = static_cast<float>(_m_input_size_user.height) /
+            auto h_scale = static_cast<float>(input_size_user.height) /
                            static_cast<float>(_m_input_size_host.height);
             coords[0] *= w_scale;
             coords[1] *= h_scale;
@@ -585,6 +711,18 @@ StatusCode YoloV5Detector<INPUT, OUTPUT>::run(const INPUT& input, OUTPUT& output
     return _m_pimpl->run(input, output);
 }
 
+/***
+ *
+ * @tparam INPUT
+ * @tparam OUTPUT
+ * @param input
+ * @param done
+ */
+template<typename INPUT, typename OUTPUT>
+void YoloV5Detector<INPUT, OUTPUT>::run_async(const INPUT& input, std::function<void(StatusCode, OUTPUT&)> done) {
+    _m_pimpl->run_async(input, std::move(done));
+}
+
 }
 }
 }
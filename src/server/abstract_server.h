@@ -8,11 +8,25 @@
 #ifndef MM_AI_SERVER_BASESERVER_H
 #define MM_AI_SERVER_BASESERVER_H
 
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <memory>
+#include <string>
+
 #include <toml/toml.hpp>
 #include <workflow/WFTask.h>
 #include <workflow/WFHttpServer.h>
 
+#include "common/process_supervisor.h"
 #include "common/status_code.h"
+#include "server/binary_rpc_message.h"
+#include "server/peer_aware_server.h"
 
 namespace jinq {
 namespace server {
@@ -44,6 +58,12 @@ public:
      */
     virtual void serve_process(WFHttpTask* task) = 0;
 
+    /***
+     * serve request of binary rpc protocol
+     * @param task
+     */
+    virtual void serve_rpc_process(WFBinaryRpcTask* task) = 0;
+
     /***
      *
      * @return
@@ -56,6 +76,9 @@ public:
  * @return
  */
     inline int start(unsigned short port) {
+        if (_m_reuse_port) {
+            return serve_reuse_port(_m_server.get(), nullptr, port);
+        }
         return _m_server->start(port);
     };
 
@@ -66,13 +89,101 @@ public:
      * @return
      */
     inline int start(const char *host, unsigned short port) {
+        if (_m_reuse_port) {
+            return serve_reuse_port(_m_server.get(), host, port);
+        }
         return _m_server->start(host, port);
     };
 
+    /***
+     * fork "process_nums" serving processes once init loaded the model workers, so that they share the
+     * weights copy-on-write. Serving processes listen on the same ports with SO_REUSEPORT and the parent
+     * only restarts crashed ones. Nothing is forked if not set or not greater than 1
+     * @param server_cfg
+     * @return true in serving processes, false in parent once all serving processes are gone
+     */
+    inline bool prefork(const toml::value& server_cfg) {
+        if (!server_cfg.contains("process_nums") || server_cfg.at("process_nums").as_integer() <= 1) {
+            return true;
+        }
+        jinq::common::ProcessSupervisor supervisor(static_cast<int>(server_cfg.at("process_nums").as_integer()));
+        int process_index = 0;
+        if (!supervisor.run(process_index)) {
+            return false;
+        }
+        _m_reuse_port = true;
+        _m_process_index = process_index;
+        return true;
+    };
+
+    /***
+     * serve co-located clients on unix domain socket set by "local_socket_path", skipped if not set or empty
+     * @param server_cfg
+     * @return
+     */
+    inline int start_local(const toml::value& server_cfg) {
+#ifndef _WIN32
+        if (!server_cfg.contains("local_socket_path")) {
+            return 0;
+        }
+        std::string socket_path = server_cfg.at("local_socket_path").as_string();
+        struct sockaddr_un addr{};
+        // unix domain socket can not be shared, it is served by the first process only
+        if (socket_path.empty() || _m_process_index != 0) {
+            return 0;
+        }
+        if (socket_path.size() >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        // remove socket file left by last run
+        unlink(socket_path.c_str());
+
+        _m_local_server = std::make_unique<PeerAwareHttpServer>([this](WFHttpTask* task) { serve_process(task); });
+        if (_m_local_server->start(reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            _m_local_server.reset();
+            return -1;
+        }
+        return 0;
+#else
+        return 0;
+#endif
+    };
+
+    /***
+     * serve binary rpc protocol on "rpc_port", skipped if not set or non-positive
+     * @param server_cfg
+     * @return
+     */
+    inline int start_rpc(const toml::value& server_cfg) {
+        if (!server_cfg.contains("rpc_port") || server_cfg.at("rpc_port").as_integer() <= 0) {
+            return 0;
+        }
+        auto rpc_port = static_cast<unsigned short>(server_cfg.at("rpc_port").as_integer());
+        WFServerParams params = SERVER_PARAMS_DEFAULT;
+        params.request_size_limit = 64 * 1024 * 1024;
+        _m_rpc_server = std::make_unique<PeerAwareServer<BinaryRpcRequest, BinaryRpcResponse>>(
+            &params, [this](WFBinaryRpcTask* task) { serve_rpc_process(task); });
+        auto ret = _m_reuse_port ?
+                   serve_reuse_port(_m_rpc_server.get(), nullptr, rpc_port) : _m_rpc_server->start(rpc_port);
+        if (ret != 0) {
+            _m_rpc_server.reset();
+            return -1;
+        }
+        return 0;
+    };
+
     /***
      *
      */
     inline void stop() {
+        if (_m_rpc_server) {
+            _m_rpc_server->stop();
+        }
+        if (_m_local_server) {
+            _m_local_server->stop();
+        }
         return _m_server->stop();
     };
 
@@ -80,6 +191,12 @@ public:
      *
      */
     inline void shutdown() {
+        if (_m_rpc_server) {
+            _m_rpc_server->shutdown();
+        }
+        if (_m_local_server) {
+            _m_local_server->shutdown();
+        }
         _m_server->shutdown();
     };
 
@@ -87,11 +204,63 @@ public:
      *
      */
     inline void wait_finish() {
+        if (_m_rpc_server) {
+            _m_rpc_server->wait_finish();
+        }
+        if (_m_local_server) {
+            _m_local_server->wait_finish();
+        }
         _m_server->wait_finish();
     }
 
+protected:
+    /***
+     * listen on a socket with SO_REUSEPORT so that preforked processes share the port
+     * @tparam SERVER
+     * @param server
+     * @param host : nullptr means any ipv4 address
+     * @param port
+     * @return
+     */
+    template<typename SERVER>
+    static int serve_reuse_port(SERVER* server, const char* host, unsigned short port) {
+#ifndef _WIN32
+        struct addrinfo hints{};
+        hints.ai_family = host == nullptr ? AF_INET : AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        struct addrinfo* addr = nullptr;
+        if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &addr) != 0) {
+            return -1;
+        }
+        int listen_fd = socket(addr->ai_family, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listen_fd < 0
+            || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+            || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) != 0
+            || bind(listen_fd, addr->ai_addr, addr->ai_addrlen) != 0
+            || listen(listen_fd, SOMAXCONN) != 0
+            || server->serve(listen_fd) != 0) {
+            if (listen_fd >= 0) {
+                close(listen_fd);
+            }
+            freeaddrinfo(addr);
+            return -1;
+        }
+        freeaddrinfo(addr);
+        return 0;
+#else
+        return -1;
+#endif
+    }
+
 protected:
     std::unique_ptr<WFHttpServer> _m_server;
+    std::unique_ptr<WFHttpServer> _m_local_server;
+    std::unique_ptr<WFBinaryRpcServer> _m_rpc_server;
+    // set in preforked serving processes
+    bool _m_reuse_port = false;
+    int _m_process_index = 0;
 };
 }
 }
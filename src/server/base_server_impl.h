@@ -8,9 +8,21 @@
 #ifndef MM_AI_SERVER_BASE_SERVER_IMPL_H
 #define MM_AI_SERVER_BASE_SERVER_IMPL_H
 
+#include <strings.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "glog/logging.h"
 #include "toml/toml.hpp"
-#include "stl_container/concurrentqueue.h"
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
@@ -21,21 +33,54 @@
 #include "workflow/Workflow.h"
 
 #include "common/md5.h"
+#include "common/access_logger.h"
+#include "common/cpu_affinity.h"
+#include "common/cpu_usage.h"
 #include "common/base64.h"
 #include "common/cv_utils.h"
 #include "common/status_code.h"
 #include "common/time_stamp.h"
 #include "common/file_path_util.h"
+#include "common/http_utils.h"
+#include "common/latency_histogram.h"
+#include "common/hash_util.h"
+#include "common/result_cache.h"
+#include "common/shared_memory.h"
+#include "common/slow_request_sampler.h"
+#include "common/socket_util.h"
+#include "common/stage_thread_pool.h"
+#include "common/token_bucket.h"
 #include "models/model_io_define.h"
+#include "server/binary_rpc_message.h"
+#include "server/peer_aware_server.h"
+#include "server/worker_pool.h"
 
 namespace jinq {
 namespace server {
+using jinq::common::AccessLogger;
+using jinq::common::access_log_entry;
 using jinq::common::Base64;
 using jinq::common::CvUtils;
 using jinq::common::FilePathUtil;
 using jinq::common::Md5;
 using jinq::common::StatusCode;
 using jinq::common::Timestamp;
+using jinq::common::LatencyHistogram;
+using jinq::common::ResultCache;
+using jinq::common::StageThreadPool;
+using jinq::common::TokenBucket;
+using jinq::common::CpuAffinity;
+using jinq::common::ScopedCpuAffinity;
+using jinq::common::CpuUsageSampler;
+using jinq::common::SharedMemoryRegion;
+using jinq::common::SlowRequestSampler;
+using jinq::common::slow_request_record;
+using jinq::common::http_util::MultipartReader;
+using jinq::common::http_util::accepts_encoding;
+using jinq::common::http_util::gzip_compress;
+using jinq::common::socket_util::is_peer_closed;
+using jinq::common::socket_util::is_local_peer;
+using jinq::common::socket_util::is_loopback_peer;
 
 template<typename WORKER, typename MODEL_OUTPUT>
 class BaseAiServerImpl {
@@ -43,7 +88,9 @@ public:
     /***
     *
     */
-    virtual ~BaseAiServerImpl() = default;
+    virtual ~BaseAiServerImpl() {
+        stop_autoscaler();
+    }
 
     /***
      *
@@ -77,6 +124,12 @@ public:
     */
     virtual void serve_process(WFHttpTask* task);
 
+    /***
+     * serve request of binary rpc protocol, shares working queue with http requests
+     * @param task
+     */
+    virtual void serve_rpc_process(WFBinaryRpcTask* task);
+
     /***
      *
      * @return
@@ -85,6 +138,13 @@ public:
         return _m_successfully_initialized;
     };
 
+    /***
+     * init optional serving options shared by all model servers
+     * @param server_section
+     * @return
+     */
+    StatusCode init_server_options(const toml::value& server_section);
+
 public:
     int max_connection_nums = 200;
     int peer_resp_timeout = 15 * 1000;
@@ -99,30 +159,236 @@ protected:
     std::atomic<size_t> _m_finished_jobs{0};
     std::atomic<size_t> _m_waiting_jobs{0};
     // worker queue
-    moodycamel::ConcurrentQueue<WORKER> _m_working_queue;
+    WorkerPool<WORKER> _m_working_queue;
     // model run timeout
     int _m_model_run_timeout = 500; // ms
     // server uri
     std::string _m_server_uri;
 
 protected:
+    struct cls_request {
+        // base64 encoded image from json body
+        std::string image_content;
+        // raw encoded image bytes from binary body, points into request buffer
+        const char* image_data = nullptr;
+        size_t image_data_size = 0;
+        // raw uint8 pixels from shared memory instead of encoded image, zero means encoded image
+        int raw_width = 0;
+        int raw_height = 0;
+        int raw_channels = 0;
+        std::string task_id;
+        bool is_valid = true;
+        // client deadline relative to request arrival, negative means no deadline
+        int64_t deadline_ms = -1;
+    };
+
     struct seriex_ctx {
         protocol::HttpResponse* response = nullptr;
+        // http requests only, response waits in series for its body to be compressed
+        SeriesWork* series = nullptr;
+        bool accept_gzip = false;
+        // set instead of response for binary rpc requests
+        BinaryRpcResponse* rpc_response = nullptr;
         StatusCode model_run_status = StatusCode::OK;
         std::string task_id;
-        std::string task_received_ts;
-        std::string task_finished_ts;
+        // formatted by access log flush thread only
+        Timestamp task_received_ts;
+        Timestamp task_finished_ts;
         bool is_task_req_valid = false;
         double worker_run_time_consuming = 0; // ms
-        double find_worker_time_consuming = 0; // ms
+        double wait_worker_time_consuming = 0; // ms
         MODEL_OUTPUT model_output;
+        Timestamp serve_start_ts;
+        // requests still waiting for a worker after deadline are dropped
+        typename WorkerPool<WORKER>::time_point deadline = WorkerPool<WORKER>::time_point::max();
+        // result cache and request coalescing, hash of encoded image bytes
+        uint64_t cache_key = 0;
+        bool has_cache_key = false;
+        // index of tenant the request belongs to
+        size_t tenant = 0;
+        // client socket probed before holding a worker, set once client is gone or response abandoned
+        int peer_fd = -1;
+        std::atomic<bool> cancelled{false};
+        std::string cached_response;
+        // dechunked binary request body
+        std::string request_body;
+        // image region mapped from co-located client's shared memory
+        std::unique_ptr<SharedMemoryRegion> shared_memory;
+        // slow request capture only, stage elapse in ms and model input bytes valid until response is made
+        double parse_time_consuming = 0;
+        double decode_time_consuming = 0;
+        double model_run_time_consuming = 0;
+        int worker_id = -1;
+        const char* image_bytes = nullptr;
+        size_t image_bytes_size = 0;
+        std::string image_bytes_buffer;
+        int raw_width = 0;
+        int raw_height = 0;
+        int raw_channels = 0;
+        // batching and pipeline mode only
+        cls_request request;
+        // pipeline mode only
+        models::io_define::common_io::mat_input model_input;
+        WFCounterTask* infer_counter = nullptr;
+        WFCounterTask* batch_counter = nullptr;
+        size_t batch_size = 1;
+        // deletes ctx once counted by the task finishing model run, which may outlive a timed out series
+        WFCounterTask* release_counter = nullptr;
     };
 
-    struct cls_request {
-        std::string image_content;
-        std::string task_id;
-        bool is_valid = true;
+    struct batch_request_ctx {
+        protocol::HttpResponse* response = nullptr;
+        bool accept_gzip = false;
+        Timestamp serve_start_ts;
+        // one ctx and one response body per request item
+        std::vector<std::unique_ptr<seriex_ctx>> items;
+        std::vector<std::string> item_bodies;
+    };
+
+protected:
+    // serving stages traced by latency histograms
+    enum serve_stage {
+        STAGE_REQUEST_PARSE = 0,
+        STAGE_BASE64_DECODE,
+        STAGE_IMAGE_DECODE,
+        STAGE_WORKER_WAIT,
+        STAGE_MODEL_RUN,
+        STAGE_RESPONSE_ENCODE,
+        STAGE_TOTAL,
+        STAGE_NUMS,
+    };
+    LatencyHistogram _m_stage_latency[STAGE_NUMS];
+    std::atomic<size_t> _m_busy_workers{0};
+    std::atomic<uint64_t> _m_worker_busy_us{0};
+    std::atomic<size_t> _m_expired_jobs{0};
+    std::atomic<size_t> _m_cancelled_jobs{0};
+
+protected:
+    // dynamic batching
+    bool _m_enable_batching = false;
+    int _m_max_batch_size = 8;
+    int _m_max_batch_delay_ms = 5; // ms
+    std::mutex _m_batch_mutex;
+    std::vector<seriex_ctx*> _m_pending_batch;
+    size_t _m_batch_generation = 0;
+
+protected:
+    // request coalescing, identical in-flight images share one model run
+    struct inflight_run {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool finished = false;
+        StatusCode status = StatusCode::OK;
+        MODEL_OUTPUT model_output;
     };
+    bool _m_enable_request_coalescing = false;
+    std::mutex _m_inflight_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<inflight_run>> _m_inflight_runs;
+    std::atomic<size_t> _m_coalesced_jobs{0};
+
+protected:
+    // admission control, requests are rejected before their body is parsed
+    std::atomic<int> _m_worker_nums{1};
+    int64_t _m_max_waiting_jobs = -1;
+    int64_t _m_max_estimated_wait_ms = -1;
+    double _m_rate_limit_qps = -1;
+    std::unique_ptr<TokenBucket> _m_rate_limiter;
+    // moving average of model run time per request and worker wait time
+    std::atomic<uint64_t> _m_recent_run_us{0};
+    std::atomic<uint64_t> _m_recent_wait_us{0};
+    std::atomic<size_t> _m_rejected_jobs{0};
+
+protected:
+    // batch request endpoint
+    int _m_max_batch_request_items = 64;
+
+protected:
+    // tenants found by request header, each one has its own worker waiting queue, tenant 0 is the default one
+    std::string _m_tenant_header = "X-Tenant-Id";
+    std::vector<std::string> _m_tenant_names = {"default"};
+    std::unordered_map<std::string, size_t> _m_tenant_index;
+    std::vector<std::unique_ptr<LatencyHistogram>> _m_tenant_wait_latency;
+
+protected:
+    // staged pipeline, decode and encode run on workflow compute threads while inference runs on its own threads
+    bool _m_enable_pipeline = false;
+    int _m_inference_threads = 0;
+    std::unique_ptr<StageThreadPool> _m_inference_pool;
+
+protected:
+    // autoscaling, worker nums follow queue wait time within [min, max] and idle workers are released after cooldown
+    bool _m_enable_autoscaling = false;
+    int _m_min_worker_nums = 1;
+    int _m_max_worker_nums = 1;
+    int _m_autoscale_interval_ms = 1000;
+    int _m_autoscale_up_wait_ms = 50;
+    double _m_autoscale_max_cpu_usage = 0.85;
+    int _m_autoscale_cooldown_s = 60;
+    std::atomic<size_t> _m_scale_ups{0};
+    std::atomic<size_t> _m_scale_downs{0};
+    // serialize autoscaling and reload since both change workers
+    std::mutex _m_scaling_mutex;
+    std::thread _m_autoscale_thread;
+    std::mutex _m_autoscale_mutex;
+    std::condition_variable _m_autoscale_cv;
+    bool _m_autoscale_stopped = false;
+
+protected:
+    // cpu affinity, each worker runs on a dedicated core set so that an idle worker means idle cores
+    int _m_cpu_cores_per_worker = 0;
+    int _m_cpu_core_offset = 0;
+    std::mutex _m_worker_cores_mutex;
+    std::unordered_map<const void*, std::vector<int>> _m_worker_cores;
+
+protected:
+    // warm up, workers run synthetic images before serving so that first requests do not hit cold sessions
+    int _m_warm_up_times = 1;
+    cv::Size _m_warm_up_image_size = cv::Size(224, 224);
+
+protected:
+    // hot reload
+    bool _m_enable_admin = false;
+    toml::value _m_server_config;
+    std::atomic<bool> _m_reloading{false};
+    std::atomic<size_t> _m_reload_times{0};
+
+protected:
+    // result cache
+    bool _m_enable_result_cache = false;
+    int64_t _m_result_cache_max_mb = 64;
+    int64_t _m_result_cache_ttl_s = 60;
+    // identify model config, responses of different model versions never share cache entries
+    std::string _m_model_version;
+    std::atomic<uint64_t> _m_result_cache_seed{0};
+    std::unique_ptr<ResultCache> _m_result_cache;
+
+protected:
+    // slow request capture, disabled while capture dir is empty
+    std::string _m_slow_request_capture_dir;
+    int64_t _m_slow_request_keep_nums = 10;
+    int64_t _m_slow_request_window_s = 60;
+    int64_t _m_slow_request_capture_files = 10;
+    std::unique_ptr<SlowRequestSampler> _m_slow_request_sampler;
+
+protected:
+    // access log, written by a background thread
+    double _m_access_log_sample_rate = 1.0;
+    int64_t _m_access_log_flush_interval_ms = 100;
+    int64_t _m_access_log_buffer_entries = 4096;
+    std::unique_ptr<AccessLogger> _m_access_logger;
+
+protected:
+    // response compression, pool is created by first compressed response so that forked children own one
+    bool _m_enable_response_compression = false;
+    int64_t _m_response_compression_min_bytes = 4096;
+    int _m_response_compression_level = 1;
+    int _m_compression_threads = 2;
+    std::once_flag _m_compression_pool_once;
+    std::unique_ptr<StageThreadPool> _m_compression_pool;
+    std::atomic<size_t> _m_compressed_responses{0};
+    std::atomic<uint64_t> _m_compression_saved_bytes{0};
+    std::mutex _m_worker_ids_mutex;
+    std::unordered_map<const void*, int> _m_worker_ids;
 
 protected:
     /***
@@ -131,10 +397,24 @@ protected:
      * @return
      */
      virtual cls_request parse_task_request(const std::string& req_body) {
+        return parse_task_request(req_body.data(), req_body.size());
+    }
+
+    /***
+     * parse json body in place without copying it
+     * @param req_body
+     * @param req_body_size
+     * @return
+     */
+    virtual cls_request parse_task_request(const char* req_body, size_t req_body_size) {
 
         rapidjson::Document doc;
-        doc.Parse(req_body.c_str());
         cls_request req{};
+        if (req_body == nullptr) {
+            req.is_valid = false;
+            return req;
+        }
+        doc.Parse(req_body, req_body_size);
 
         if (doc.HasParseError() || doc.IsNull() || doc.ObjectEmpty()) {
             req.image_content = "";
@@ -145,7 +425,7 @@ protected:
                 req.image_content = "";
                 req.is_valid = false;
             } else {
-                req.image_content = doc["img_data"].GetString();
+                req.image_content.assign(doc["img_data"].GetString(), doc["img_data"].GetStringLength());
                 req.is_valid = true;
             }
 
@@ -155,190 +435,3001 @@ protected:
             } else {
                 req.task_id = doc["req_id"].GetString();
             }
+
+            if (doc.HasMember("deadline_ms") && doc["deadline_ms"].IsInt64()) {
+                req.deadline_ms = doc["deadline_ms"].GetInt64();
+            }
         }
 
         return req;
     };
 
     /***
-     *
-     * @param task_id
-     * @param status
-     * @param model_output
+     * parse json array of {req_id, img_data} items posted to batch endpoint
+     * @param req_body
+     * @param req_body_size
+     * @param reqs
+     * @return false if body is not a json array of objects
+     */
+    virtual bool parse_batch_task_request(const char* req_body, size_t req_body_size, std::vector<cls_request>& reqs);
+
+    /***
+     * deadline from X-Deadline-Ms header
+     * @param req
+     * @return negative if missing
+     */
+    static int64_t parse_deadline_header(protocol::HttpRequest* req);
+
+    /***
+     * tenant from tenant header, unknown tenants belong to the default one
+     * @param req
      * @return
      */
-    virtual std::string make_response_body(
-        const std::string& task_id,
-        const StatusCode& status,
-        const MODEL_OUTPUT& model_output) = 0;
+    size_t find_tenant(protocol::HttpRequest* req) const;
 
     /***
-     *
+     * parse json, octet-stream or multipart/form-data request according to its content type
      * @param req
      * @param ctx
+     * @return
      */
-    virtual void do_work(const cls_request& req, seriex_ctx* ctx);
+    virtual cls_request parse_http_request(protocol::HttpRequest* req, seriex_ctx* ctx);
+
+    /***
+     * parse binary rpc request, image bytes are used in place
+     * @param req
+     * @return
+     */
+    virtual cls_request parse_rpc_request(BinaryRpcRequest* req);
 
     /***
      *
-     * @param task
+     * @param req
+     * @param ctx
+     * @param content_type
+     * @param cursor
+     * @return
      */
-    virtual void do_work_cb(const WFGoTask* task);
-};
+    cls_request parse_request_body(
+        protocol::HttpRequest* req,
+        seriex_ctx* ctx,
+        const std::string& content_type,
+        protocol::HttpHeaderCursor& cursor);
 
-/*********** Public Func Sets **************/
+    /***
+     * map image posted by co-located client through shared memory, see X-Shm-* headers
+     * @param ctx
+     * @param cursor
+     * @return
+     */
+    cls_request parse_shared_memory_request(seriex_ctx* ctx, protocol::HttpHeaderCursor& cursor);
 
-/***
- *
- * @tparam WORKER
- * @tparam MODEL_INPUT
- * @tparam MODEL_OUTPUT
- * @param task
- */
-template<typename WORKER, typename MODEL_OUTPUT>
-void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::serve_process(WFHttpTask* task) {
-    // welcome message
-    if (strcmp(task->get_req()->get_request_uri(), "/welcome") == 0) {
-        task->get_resp()->append_output_body("<html>Welcome to jinq ai server</html>");
-        return;
-    }
-    // hello world message
-    else if (strcmp(task->get_req()->get_request_uri(), "/hello_world") == 0) {
-        task->get_resp()->append_output_body("<html>Hello World !!!</html>");
-        return;
-    }
-    // model service
-    else if (strcmp(task->get_req()->get_request_uri(), _m_server_uri.c_str()) == 0) {
-        // parse request body
-        auto* req = task->get_req();
-        auto* resp = task->get_resp();
-        auto cls_task_req = parse_task_request(protocol::HttpUtil::decode_chunked_body(req));
-        _m_waiting_jobs++;
-        _m_received_jobs++;
-        // init series work
-        auto* series = series_of(task);
-        auto* ctx = new seriex_ctx;
-        ctx->response = resp;
-        series->set_context(ctx);
-        // do model work
-        auto&& go_proc = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work, this, std::placeholders::_1, std::placeholders::_2);
-        WFGoTask* serve_task = nullptr;
-        if (_m_model_run_timeout <= 0) {
-            serve_task = WFTaskFactory::create_go_task(_m_server_uri, go_proc, cls_task_req, ctx);
-        } else {
-            serve_task = WFTaskFactory::create_timedgo_task(
-                0, _m_model_run_timeout * 1e6, _m_server_uri, go_proc, cls_task_req, ctx);
-        }
-        auto&& go_proc_cb = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work_cb, this, serve_task);
-        serve_task->set_callback(go_proc_cb);
-        *series << serve_task;
-        WFCounterTask* counter = WFTaskFactory::create_counter_task("release_ctx", 1, [](const WFCounterTask* task){
-            delete (seriex_ctx*)series_of(task)->get_context();
-        });
-        *series << counter;
-        return;
-    }
-    // not found valid url
-    else {
-        task->get_resp()->append_output_body("<html>404 Not Found</html>");
-        return;
-    }
-}
+    /***
+     * create model workers according to server config, model config file is read from disk again
+     * every time so that reload can pick up new model params and weights
+     * @param config
+     * @param workers
+     * @return
+     */
+    virtual StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<WORKER>& workers) = 0;
 
-/***
- *
- * @tparam WORKER
- * @tparam MODEL_INPUT
- * @tparam MODEL_OUTPUT
- * @param req
- * @param ctx
- */
-template<typename WORKER, typename MODEL_OUTPUT>
-void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work(
-    const BaseAiServerImpl::cls_request& req,
-    BaseAiServerImpl::seriex_ctx* ctx) {
+    /***
+     * create workers and fill working queue
+     * @param config
+     * @return
+     */
+    StatusCode init_working_queue(const decltype(toml::parse(""))& config);
 
-    // get task receive timestamp
-    ctx->task_id = req.task_id;
-    ctx->is_task_req_valid = req.is_valid;
-    auto task_receive_ts = Timestamp::now();
-    ctx->task_received_ts = task_receive_ts.to_format_str();
+    /***
+     * build and warm up a new set of workers in background then swap them into working queue,
+     * in-flight requests drain on the old workers
+     * @return
+     */
+    StatusCode reload_workers();
 
-    // get model worker
-    WORKER worker;
-    auto find_worker_start_ts = Timestamp::now();
+    /***
+     * run inference on a synthetic image of model input size so that lazy model initialization is done before serving
+     * @param worker
+     * @param warm_up_times
+     * @return
+     */
+    StatusCode warm_up_worker(WORKER& worker, int warm_up_times = 1);
 
-    while (!_m_working_queue.try_dequeue(worker)) {}
+    /***
+     * assign dedicated core set of each worker, lowest core blocks not held by pinned workers come first
+     * @param workers
+     */
+    void assign_worker_cores(const std::vector<WORKER>& workers);
 
-    ctx->find_worker_time_consuming = (Timestamp::now() - find_worker_start_ts) * 1000;
+    /***
+     * drop core sets of all workers except the given ones
+     * @param workers
+     */
+    void retain_worker_cores(const std::vector<WORKER>& workers);
 
-    // construct model input
-    models::io_define::common_io::base64_input model_input{req.image_content};
+    /***
+     *
+     * @param worker
+     * @return empty if worker is not pinned
+     */
+    std::vector<int> get_worker_cores(const WORKER& worker);
 
-    // do model inference
-    StatusCode status;
-    if (req.is_valid) {
-        status = worker->run(model_input, ctx->model_output);
+    /***
+     * small stable id of worker for slow request capture, assigned on first sight
+     * @param worker
+     * @return
+     */
+    int get_worker_id(const WORKER& worker);
 
-        if (status != StatusCode::OK) {
-            LOG(ERROR) << "worker run failed";
-        }
-    } else {
-        status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
-    }
-    ctx->model_run_status = status;
+    /***
+     * record model run of ctx for slow request capture
+     * @param ctx
+     * @param worker
+     * @param run_start_ts
+     */
+    void trace_model_run(seriex_ctx* ctx, const WORKER& worker, const Timestamp& run_start_ts);
 
-    // restore worker queue
-    while (!_m_working_queue.enqueue(std::move(worker))) {}
+    /***
+     * offer finished request to slow request sampler
+     * @param ctx
+     * @param status
+     * @param encode_time_consuming
+     * @param total_time_consuming
+     */
+    void sample_slow_request(
+        seriex_ctx* ctx, StatusCode status, double encode_time_consuming, double total_time_consuming);
 
-    // update ctx
-    auto task_finish_ts = Timestamp::now();
-    ctx->task_finished_ts = task_finish_ts.to_format_str();
-    ctx->worker_run_time_consuming = (task_finish_ts - task_receive_ts) * 1000;
-    WFTaskFactory::count_by_name("release_ctx");
-}
+    /***
+     * warm up all idle workers in working queue, called during init before server starts listening
+     * @return
+     */
+    StatusCode warm_up_workers();
 
-/***
- *
- * @tparam WORKER
- * @tparam MODEL_INPUT
- * @tparam MODEL_OUTPUT
- * @param task
- */
-template<typename WORKER, typename MODEL_OUTPUT>
-void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work_cb(const WFGoTask* task) {
-    auto state = task->get_state();
-    auto* ctx = (seriex_ctx*)series_of(task)->get_context();
+    /***
+     * model input image size read from model config files referred by server config
+     * @param config
+     * @param input_size
+     * @return false if not found
+     */
+    static bool find_model_input_size(const toml::value& config, cv::Size& input_size);
 
-    // fill response
-    StatusCode status;
+    /***
+     * max model_threads_num of model config files referred by server config, models use 4 threads when missing
+     * @param config
+     * @return
+     */
+    static int find_model_threads_num(const toml::value& config);
 
-    if (state != WFT_STATE_SUCCESS) {
-        LOG(ERROR) << "task: " << ctx->task_id << " model run timeout";
-        status = StatusCode::MODEL_RUN_TIMEOUT;
-    } else {
-        status = ctx->model_run_status;
+    /***
+     * result cache key seed, changes with model version and every reload
+     * @return
+     */
+    uint64_t make_result_cache_seed() const {
+        return jinq::common::hash_util::murmur_hash64(
+            _m_server_uri + "@" + _m_model_version + "#" + std::to_string(_m_reload_times));
     }
 
-    std::string task_id = ctx->is_task_req_valid ? ctx->task_id : "";
-    std::string response_body = make_response_body(task_id, status, ctx->model_output);
-    ctx->response->append_output_body(std::move(response_body));
+    /***
+     * fetch encoded image bytes of request, base64 image content is decoded into buffer
+     * @param req
+     * @param buffer
+     * @param data
+     * @param size
+     * @return
+     */
+    bool load_image_bytes(const cls_request& req, std::string& buffer, const char*& data, size_t& size);
 
-    // update task count
-    _m_finished_jobs++;
-    _m_waiting_jobs--;
+    /***
+     * decode image straight from encoded image bytes
+     * @param data
+     * @param size
+     * @param image
+     * @return
+     */
+    bool decode_image(const char* data, size_t size, cv::Mat& image);
+
+    /***
+     * hash encoded image bytes and look up cached response, hash is kept for request coalescing as well
+     * @param ctx
+     * @param data
+     * @param size
+     * @return true if cache hit
+     */
+    bool lookup_result_cache(seriex_ctx* ctx, const char* data, size_t size, uint64_t seed_mix = 0);
+
+    /***
+     * decode model input of request, response is taken from result cache if possible
+     * @param req
+     * @param ctx
+     * @param model_input
+     * @return false if image is invalid or cache hit, which means nothing to run
+     */
+    bool prepare_model_input(
+        const cls_request& req, seriex_ctx* ctx, models::io_define::common_io::mat_input& model_input);
+
+    /***
+     * request deadline from client deadline and model run timeout, whichever comes first
+     * @param req
+     * @return
+     */
+    typename WorkerPool<WORKER>::time_point make_deadline(const cls_request& req) const;
+
+    /***
+     *
+     * @param ctx
+     * @return
+     */
+    static bool is_expired(const seriex_ctx* ctx) {
+        return ctx->deadline != WorkerPool<WORKER>::time_point::max() && WorkerPool<WORKER>::clock_type::now() >= ctx->deadline;
+    }
+
+    /***
+     * nobody waits for the result any more, client closed its connection or response was abandoned
+     * @param ctx
+     * @return
+     */
+    static bool is_cancelled(seriex_ctx* ctx) {
+        if (!ctx->cancelled && is_peer_closed(ctx->peer_fd)) {
+            ctx->cancelled = true;
+        }
+        return ctx->cancelled;
+    }
+
+    /***
+     * check queue depth, estimated wait and request rate
+     * @param retry_after_ms
+     * @param job_nums : images carried by the request, all admitted or rejected together
+     * @return SERVER_OVERLOADED or SERVER_RATE_LIMITED if request is rejected
+     */
+    StatusCode check_admission(int64_t& retry_after_ms, size_t job_nums = 1);
+
+    /***
+     * check admission of http request, rejected request gets 429 or 503 with Retry-After
+     * @param resp
+     * @param job_nums
+     * @return false if request is rejected
+     */
+    bool admit_request(protocol::HttpResponse* resp, size_t job_nums = 1);
+
+    /***
+     * queue parsed request for model run in batching, pipeline or plain mode, ctx is released
+     * at the end of series
+     * @param series
+     * @param ctx
+     * @param task_req
+     */
+    void dispatch_task_request(SeriesWork* series, seriex_ctx* ctx, cls_request task_req);
+
+    /***
+     * update moving average of elapse time
+     * @param recent_us
+     * @param elapse_ms
+     */
+    static void update_moving_average(std::atomic<uint64_t>& recent_us, double elapse_ms) {
+        // racy read-modify-write is fine for an estimate
+        auto sample_us = static_cast<uint64_t>(elapse_ms * 1000);
+        auto average_us = recent_us.load(std::memory_order_relaxed);
+        recent_us.store(average_us == 0 ? sample_us : (average_us * 7 + sample_us) / 8, std::memory_order_relaxed);
+    }
+
+    /***
+     * start background thread adjusting worker nums
+     */
+    void start_autoscaler();
+
+    /***
+     *
+     */
+    void stop_autoscaler();
+
+    /***
+     * grow worker pool under queue pressure if cpu has headroom, shrink it after idle cooldown
+     * @param cpu_usage
+     * @param last_pressure_ts
+     */
+    void autoscale_once(double cpu_usage, Timestamp& last_pressure_ts);
+
+    /***
+     * create, pin and warm up one more worker
+     * @return
+     */
+    StatusCode add_worker();
+
+    /***
+     * release one idle worker
+     * @return false if no worker is idle
+     */
+    bool release_idle_worker();
+
+    /***
+     * prometheus text exposition of server metrics
+     * @return
+     */
+    std::string make_metrics_body();
+
+    /***
+     * run model on one worker and record worker usage
+     * @tparam MODEL_INPUT
+     * @param worker
+     * @param input
+     * @param output
+     * @return
+     */
+    template<typename MODEL_INPUT>
+    StatusCode run_worker(WORKER& worker, const MODEL_INPUT& input, MODEL_OUTPUT& output);
+
+    /***
+     * record usage of one worker run started at run_start_ts
+     * @param run_start_ts
+     * @param input_nums
+     */
+    void observe_worker_run(const Timestamp& run_start_ts, size_t input_nums = 1);
+
+    /***
+     * run model input, requests of identical image join the in-flight run if coalescing is enabled
+     * @param model_input
+     * @param ctx
+     * @return
+     */
+    StatusCode infer_on_worker(const models::io_define::common_io::mat_input& model_input, seriex_ctx* ctx);
+
+    /***
+     * hold a model worker before deadline and run model input on it
+     * @param model_input
+     * @param ctx
+     * @return
+     */
+    StatusCode hold_worker_and_run(const models::io_define::common_io::mat_input& model_input, seriex_ctx* ctx);
+
+    /***
+     * wait for a model worker of request's tenant before deadline
+     * @param ctx
+     * @param worker
+     * @param worker_generation
+     * @return MODEL_RUN_DEADLINE_EXCEEDED or MODEL_RUN_CANCELLED if no worker is held
+     */
+    StatusCode acquire_worker(seriex_ctx* ctx, WORKER& worker, size_t& worker_generation);
+
+    /***
+     * run pipeline request asynchronously on a model worker. The worker is handed on as soon as
+     * the model takes the next input, request finishes once model output is ready
+     * @param ctx
+     */
+    void submit_on_worker(seriex_ctx* ctx);
+
+    /***
+     * record model run status and finish time of request
+     * @param ctx
+     * @param status
+     * @param task_receive_ts
+     */
+    void finish_model_run(seriex_ctx* ctx, StatusCode status, const Timestamp& task_receive_ts);
+
+    /***
+     * pipeline stage decoding request image on workflow compute threads
+     * @param ctx
+     */
+    void decode_stage(seriex_ctx* ctx);
+
+    /***
+     * pipeline stage holding a model worker only for inference, runs on inference threads
+     * @param ctx
+     */
+    void infer_stage(seriex_ctx* ctx);
+
+    /***
+     * pipeline stage encoding response on workflow compute threads
+     * @param ctx
+     */
+    void encode_stage(seriex_ctx* ctx);
+
+    /***
+     *
+     * @param task_id
+     * @param status
+     * @param model_output
+     * @return
+     */
+    virtual std::string make_response_body(
+        const std::string& task_id,
+        const StatusCode& status,
+        const MODEL_OUTPUT& model_output) = 0;
+
+    /***
+     * binary rpc response body with packed model output
+     * @param task_id
+     * @param status
+     * @param model_output
+     * @return
+     */
+    virtual std::string make_rpc_response_body(
+        const std::string& task_id,
+        const StatusCode& status,
+        const MODEL_OUTPUT& model_output) {
+        std::string response_body;
+        binary_rpc::pack_response_head(static_cast<int32_t>(status), task_id, response_body);
+        if (status == StatusCode::OK) {
+            binary_rpc::pack_model_output(model_output, response_body);
+        }
+        return response_body;
+    }
+
+    /***
+     *
+     * @param req
+     * @param ctx
+     */
+    virtual void do_work(const cls_request& req, seriex_ctx* ctx);
+
+    /***
+     *
+     * @param task
+     */
+    virtual void do_work_cb(const WFGoTask* task);
+
+    /***
+     * run a batch of pending requests with one model invocation
+     * @param batch
+     */
+    virtual void do_batch_work(const std::vector<seriex_ctx*>& batch);
+
+    /***
+     *
+     * @param task
+     */
+    virtual void do_batch_work_cb(const WFCounterTask* task);
+
+    /***
+     * append request into pending batch, dispatch it once full
+     * @param ctx
+     */
+    void add_to_batch(seriex_ctx* ctx);
+
+    /***
+     * dispatch pending batch if it was not dispatched since timer started
+     * @param generation
+     */
+    void flush_batch(size_t generation);
+
+    /***
+     *
+     * @param batch
+     */
+    void dispatch_batch(std::vector<seriex_ctx*> batch);
+
+    /***
+     *
+     * @param ctx
+     * @param status
+     */
+    void fill_response(seriex_ctx* ctx, StatusCode status);
+
+    /***
+     * append body to http response, large bodies of clients accepting gzip are compressed on compression
+     * pool while series waits for them
+     * @param series
+     * @param response
+     * @param body
+     * @param accept_gzip
+     */
+    void append_http_body(SeriesWork* series, protocol::HttpResponse* response, std::string body, bool accept_gzip);
+
+    /***
+     *
+     * @param req
+     * @return true if compression enabled and client accepts gzip
+     */
+    bool is_gzip_accepted(protocol::HttpRequest* req) const;
+
+    /***
+     * make response body of request from model output or result cache, update task count
+     * @param ctx
+     * @param status
+     * @return
+     */
+    std::string make_task_response(seriex_ctx* ctx, StatusCode status);
+
+    /***
+     * fan out items of a batch request across model workers
+     * @param task
+     */
+    void serve_batch_request(WFHttpTask* task);
+
+    /***
+     * run one item of a batch request
+     * @param batch_ctx
+     * @param index
+     */
+    void do_batch_request_item(batch_request_ctx* batch_ctx, size_t index);
+
+    /***
+     *
+     * @param item_bodies
+     * @return
+     */
+    static std::string make_batch_response_body(const std::vector<std::string>& item_bodies) {
+        std::string body = "{\"code\":0,\"msg\":\"success\",\"data\":[";
+        for (size_t i = 0; i < item_bodies.size(); ++i) {
+            if (i != 0) {
+                body += ",";
+            }
+            body += item_bodies[i];
+        }
+        body += "]}";
+        return body;
+    }
+
+    /***
+     *
+     * @param status
+     * @param msg
+     * @return
+     */
+    static std::string make_admin_response_body(StatusCode status, const std::string& msg) {
+        rapidjson::StringBuffer buf;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+        writer.StartObject();
+        writer.Key("code");
+        writer.Int(static_cast<int>(status));
+        writer.Key("msg");
+        writer.String(msg.c_str());
+        writer.EndObject();
+        return buf.GetString();
+    }
+
+    /***
+     *
+     * @param task_id
+     * @return
+     */
+    static std::string req_id_json_field(const std::string& task_id) {
+        rapidjson::StringBuffer buf;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+        writer.String(task_id.c_str(), static_cast<rapidjson::SizeType>(task_id.size()));
+        return std::string("\"req_id\":") + buf.GetString();
+    }
+
+    /***
+     * blank req id of response body so that it can be shared by other requests
+     * @param response_body
+     * @param task_id
+     * @return empty string if req id field not found
+     */
+    static std::string strip_req_id(const std::string& response_body, const std::string& task_id) {
+        auto req_id_field = req_id_json_field(task_id);
+        auto pos = response_body.find(req_id_field);
+        if (pos == std::string::npos) {
+            return "";
+        }
+        auto stripped_body = response_body;
+        stripped_body.replace(pos, req_id_field.size(), req_id_json_field(""));
+        return stripped_body;
+    }
+
+    /***
+     *
+     * @param cached_response
+     * @param task_id
+     * @return
+     */
+    static std::string fill_cached_req_id(const std::string& cached_response, const std::string& task_id) {
+        auto blank_field = req_id_json_field("");
+        auto filled_body = cached_response;
+        filled_body.replace(filled_body.find(blank_field), blank_field.size(), req_id_json_field(task_id));
+        return filled_body;
+    }
+};
+
+/*********** Public Func Sets **************/
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param server_section
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::init_server_options(const toml::value& server_section) {
+    // threads started by init do not survive fork of serving processes
+    bool is_preforked = server_section.contains("process_nums") && server_section.at("process_nums").as_integer() > 1;
+    bool has_init_threads = (server_section.contains("enable_pipeline") && server_section.at("enable_pipeline").as_boolean())
+                            || (server_section.contains("enable_autoscaling") && server_section.at("enable_autoscaling").as_boolean());
+    if (is_preforked && has_init_threads) {
+        LOG(ERROR) << "staged pipeline and autoscaling can not be enabled together with process_nums";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    // backend thread pools of models are created by model load as well
+    if (is_preforked && find_model_threads_num(_m_server_config) > 1) {
+        LOG(ERROR) << "model_threads_num of models must be 1 together with process_nums";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    // core blocks are assigned before fork, every serving process would pin its workers to the same cores
+    if (is_preforked && server_section.contains("cpu_cores_per_worker")
+        && server_section.at("cpu_cores_per_worker").as_integer() > 0) {
+        LOG(ERROR) << "cpu_cores_per_worker can not be enabled together with process_nums";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    // admin endpoints
+    if (server_section.contains("enable_admin")) {
+        _m_enable_admin = server_section.at("enable_admin").as_boolean();
+    }
+    // init dynamic batching options
+    if (server_section.contains("enable_batching")) {
+        _m_enable_batching = server_section.at("enable_batching").as_boolean();
+    }
+    if (server_section.contains("max_batch_size")) {
+        _m_max_batch_size = static_cast<int>(server_section.at("max_batch_size").as_integer());
+    }
+    if (server_section.contains("max_batch_delay_ms")) {
+        _m_max_batch_delay_ms = static_cast<int>(server_section.at("max_batch_delay_ms").as_integer());
+    }
+    // init result cache options
+    if (server_section.contains("enable_result_cache")) {
+        _m_enable_result_cache = server_section.at("enable_result_cache").as_boolean();
+    }
+    if (server_section.contains("result_cache_max_mb")) {
+        _m_result_cache_max_mb = server_section.at("result_cache_max_mb").as_integer();
+    }
+    if (server_section.contains("result_cache_ttl_s")) {
+        _m_result_cache_ttl_s = server_section.at("result_cache_ttl_s").as_integer();
+    }
+    if (server_section.contains("model_version")) {
+        _m_model_version = server_section.at("model_version").as_string();
+    }
+    _m_result_cache_seed = make_result_cache_seed();
+    if (_m_enable_result_cache) {
+        if (_m_result_cache_max_mb <= 0) {
+            LOG(ERROR) << "invalid result cache memory budget: " << _m_result_cache_max_mb << " MB";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        _m_result_cache.reset(new ResultCache(
+            static_cast<size_t>(_m_result_cache_max_mb) * 1024 * 1024, _m_result_cache_ttl_s * 1000));
+        LOG(INFO) << "result cache enabled, memory budget: " << _m_result_cache_max_mb
+                  << " MB, ttl: " << _m_result_cache_ttl_s << " s, model version: " << _m_model_version;
+    }
+    // init access log options
+    if (server_section.contains("access_log_sample_rate")) {
+        const auto& sample_rate = server_section.at("access_log_sample_rate");
+        _m_access_log_sample_rate = sample_rate.is_integer() ?
+                                    static_cast<double>(sample_rate.as_integer()) : sample_rate.as_floating();
+    }
+    if (server_section.contains("access_log_flush_interval_ms")) {
+        _m_access_log_flush_interval_ms = server_section.at("access_log_flush_interval_ms").as_integer();
+    }
+    if (server_section.contains("access_log_buffer_entries")) {
+        _m_access_log_buffer_entries = server_section.at("access_log_buffer_entries").as_integer();
+    }
+    if (_m_access_log_sample_rate < 0 || _m_access_log_sample_rate > 1) {
+        LOG(ERROR) << "invalid access log sample rate: " << _m_access_log_sample_rate << ", should be in [0, 1]";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    if (_m_access_log_flush_interval_ms <= 0 || _m_access_log_buffer_entries <= 0) {
+        LOG(ERROR) << "invalid access log options, flush interval and buffer entries should be positive";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    _m_access_logger.reset(new AccessLogger(
+        _m_server_uri, [](const std::string& lines) { LOG(INFO) << lines; }, _m_access_log_sample_rate,
+        _m_access_log_flush_interval_ms, static_cast<size_t>(_m_access_log_buffer_entries)));
+    // init response compression options
+    if (server_section.contains("enable_response_compression")) {
+        _m_enable_response_compression = server_section.at("enable_response_compression").as_boolean();
+    }
+    if (server_section.contains("response_compression_min_bytes")) {
+        _m_response_compression_min_bytes = server_section.at("response_compression_min_bytes").as_integer();
+    }
+    if (server_section.contains("response_compression_level")) {
+        _m_response_compression_level = static_cast<int>(server_section.at("response_compression_level").as_integer());
+    }
+    if (server_section.contains("compression_threads")) {
+        _m_compression_threads = static_cast<int>(server_section.at("compression_threads").as_integer());
+    }
+    if (_m_enable_response_compression) {
+        if (_m_response_compression_level < 1 || _m_response_compression_level > 9 || _m_compression_threads <= 0) {
+            LOG(ERROR) << "invalid response compression options, level should be in [1, 9] and threads positive";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        LOG(INFO) << "response compression enabled, min bytes: " << _m_response_compression_min_bytes
+                  << ", level: " << _m_response_compression_level << ", threads: " << _m_compression_threads;
+    }
+    // init slow request capture options
+    if (server_section.contains("slow_request_capture_dir")) {
+        _m_slow_request_capture_dir = server_section.at("slow_request_capture_dir").as_string();
+    }
+    if (server_section.contains("slow_request_keep_nums")) {
+        _m_slow_request_keep_nums = server_section.at("slow_request_keep_nums").as_integer();
+    }
+    if (server_section.contains("slow_request_window_s")) {
+        _m_slow_request_window_s = server_section.at("slow_request_window_s").as_integer();
+    }
+    if (server_section.contains("slow_request_capture_files")) {
+        _m_slow_request_capture_files = server_section.at("slow_request_capture_files").as_integer();
+    }
+    if (!_m_slow_request_capture_dir.empty()) {
+        if (!FilePathUtil::is_dir_exist(_m_slow_request_capture_dir)) {
+            LOG(ERROR) << "slow request capture dir: " << _m_slow_request_capture_dir << " not exist";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        if (_m_slow_request_keep_nums <= 0 || _m_slow_request_window_s <= 0 || _m_slow_request_capture_files <= 0) {
+            LOG(ERROR) << "invalid slow request capture options, keep nums, window and capture files should be positive";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        // capture files of different servers sharing one dir never collide
+        auto file_prefix = _m_server_uri;
+        std::replace(file_prefix.begin(), file_prefix.end(), '/', '_');
+        file_prefix = FilePathUtil::concat_path(_m_slow_request_capture_dir, "slow_requests" + file_prefix);
+        _m_slow_request_sampler.reset(new SlowRequestSampler(
+            file_prefix, static_cast<size_t>(_m_slow_request_keep_nums), _m_slow_request_window_s * 1000,
+            static_cast<size_t>(_m_slow_request_capture_files)));
+        LOG(INFO) << "slow request capture enabled, keep slowest " << _m_slow_request_keep_nums << " requests every "
+                  << _m_slow_request_window_s << " s into " << file_prefix << ".[0-"
+                  << _m_slow_request_capture_files - 1 << "].bin";
+    }
+    // init request coalescing options
+    if (server_section.contains("enable_request_coalescing")) {
+        _m_enable_request_coalescing = server_section.at("enable_request_coalescing").as_boolean();
+    }
+    if (_m_enable_request_coalescing) {
+        LOG(INFO) << "request coalescing enabled";
+    }
+
+    // init staged pipeline options
+    if (server_section.contains("enable_pipeline")) {
+        _m_enable_pipeline = server_section.at("enable_pipeline").as_boolean();
+    }
+    _m_inference_threads = static_cast<int>(server_section.at("worker_nums").as_integer());
+    if (server_section.contains("inference_threads")) {
+        _m_inference_threads = static_cast<int>(server_section.at("inference_threads").as_integer());
+    }
+    if (_m_enable_pipeline) {
+        if (_m_enable_batching) {
+            LOG(ERROR) << "staged pipeline can not be enabled together with dynamic batching";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        if (_m_inference_threads <= 0) {
+            LOG(ERROR) << "invalid inference threads: " << _m_inference_threads;
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        _m_inference_pool.reset(new StageThreadPool(static_cast<size_t>(_m_inference_threads)));
+        LOG(INFO) << "staged pipeline enabled, inference threads: " << _m_inference_threads;
+    }
+
+    // init admission control options
+    _m_worker_nums = std::max(1, static_cast<int>(server_section.at("worker_nums").as_integer()));
+    if (server_section.contains("max_waiting_jobs")) {
+        _m_max_waiting_jobs = server_section.at("max_waiting_jobs").as_integer();
+    }
+    if (server_section.contains("max_estimated_wait_ms")) {
+        _m_max_estimated_wait_ms = server_section.at("max_estimated_wait_ms").as_integer();
+    }
+    if (server_section.contains("rate_limit_qps")) {
+        const auto& rate_limit_qps = server_section.at("rate_limit_qps");
+        _m_rate_limit_qps = rate_limit_qps.is_integer() ?
+                            static_cast<double>(rate_limit_qps.as_integer()) : rate_limit_qps.as_floating();
+    }
+    if (_m_rate_limit_qps > 0) {
+        double rate_limit_burst = _m_rate_limit_qps;
+        if (server_section.contains("rate_limit_burst")) {
+            rate_limit_burst = static_cast<double>(server_section.at("rate_limit_burst").as_integer());
+        }
+        _m_rate_limiter.reset(new TokenBucket(_m_rate_limit_qps, rate_limit_burst));
+    }
+    LOG(INFO) << "admission control, max waiting jobs: " << _m_max_waiting_jobs
+              << ", max estimated wait: " << _m_max_estimated_wait_ms << " ms"
+              << ", rate limit: " << _m_rate_limit_qps << " qps";
+
+    // init batch request endpoint options
+    if (server_section.contains("max_batch_request_items")) {
+        _m_max_batch_request_items = static_cast<int>(server_section.at("max_batch_request_items").as_integer());
+    }
+    if (_m_max_batch_request_items <= 0) {
+        LOG(ERROR) << "invalid max batch request items: " << _m_max_batch_request_items;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    // init tenant options
+    if (server_section.contains("tenant_header")) {
+        _m_tenant_header = server_section.at("tenant_header").as_string();
+    }
+    if (server_section.contains("tenants")) {
+        for (const auto& tenant : server_section.at("tenants").as_array()) {
+            std::string tenant_name = tenant.at("name").as_string();
+            double weight = 1.0;
+            if (tenant.contains("weight")) {
+                const auto& tenant_weight = tenant.at("weight");
+                weight = tenant_weight.is_integer() ?
+                         static_cast<double>(tenant_weight.as_integer()) : tenant_weight.as_floating();
+            }
+            int64_t max_concurrency = 0;
+            if (tenant.contains("max_concurrency")) {
+                max_concurrency = tenant.at("max_concurrency").as_integer();
+            }
+            if (tenant_name.empty() || weight <= 0 || _m_tenant_index.find(tenant_name) != _m_tenant_index.end()) {
+                LOG(ERROR) << "invalid or duplicated tenant: " << tenant_name << ", weight: " << weight;
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+            // default tenant may be tuned as well
+            size_t tenant_index = 0;
+            if (tenant_name != _m_tenant_names[0]) {
+                tenant_index = _m_tenant_names.size();
+                _m_tenant_names.push_back(tenant_name);
+            }
+            _m_tenant_index[tenant_name] = tenant_index;
+            _m_working_queue.configure_tenant(
+                tenant_index, weight, max_concurrency > 0 ? static_cast<size_t>(max_concurrency) : 0);
+            LOG(INFO) << "tenant: " << tenant_name << ", weight: " << weight << ", max concurrency: " << max_concurrency;
+        }
+    }
+    for (size_t index = _m_tenant_wait_latency.size(); index < _m_tenant_names.size(); ++index) {
+        _m_tenant_wait_latency.emplace_back(new LatencyHistogram);
+    }
+
+    if (_m_enable_batching) {
+        if (_m_max_batch_size <= 0 || _m_max_batch_delay_ms < 0) {
+            LOG(ERROR) << "invalid batching params, max batch size: " << _m_max_batch_size
+                       << ", max batch delay: " << _m_max_batch_delay_ms << " ms";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        // batches of mixed tenants wait for workers as one, tenant weights and limits could not apply
+        if (_m_tenant_names.size() > 1 || !_m_tenant_index.empty()) {
+            LOG(ERROR) << "tenants can not be configured together with dynamic batching";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        LOG(INFO) << "dynamic batching enabled, max batch size: " << _m_max_batch_size
+                  << ", max batch delay: " << _m_max_batch_delay_ms << " ms";
+    }
+
+    // pin workers to dedicated cores, workers are in working queue already
+    if (server_section.contains("cpu_cores_per_worker")) {
+        _m_cpu_cores_per_worker = static_cast<int>(server_section.at("cpu_cores_per_worker").as_integer());
+    }
+    if (server_section.contains("cpu_core_offset")) {
+        _m_cpu_core_offset = static_cast<int>(server_section.at("cpu_core_offset").as_integer());
+    }
+    if (_m_cpu_cores_per_worker > 0) {
+        std::vector<WORKER> workers;
+        WORKER worker;
+        while (_m_working_queue.try_dequeue(worker)) {
+            workers.push_back(std::move(worker));
+        }
+        assign_worker_cores(workers);
+        for (auto& pinned_worker : workers) {
+            _m_working_queue.enqueue(std::move(pinned_worker));
+        }
+    }
+
+    // warm up workers before server starts listening, pinned workers touch their memory on local numa node
+    if (server_section.contains("warm_up_times")) {
+        _m_warm_up_times = static_cast<int>(server_section.at("warm_up_times").as_integer());
+    }
+    find_model_input_size(_m_server_config, _m_warm_up_image_size);
+    if (warm_up_workers() != StatusCode::OK) {
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    // init autoscaling options
+    if (server_section.contains("enable_autoscaling")) {
+        _m_enable_autoscaling = server_section.at("enable_autoscaling").as_boolean();
+    }
+    _m_min_worker_nums = _m_worker_nums;
+    _m_max_worker_nums = _m_worker_nums;
+    if (server_section.contains("min_worker_nums")) {
+        _m_min_worker_nums = static_cast<int>(server_section.at("min_worker_nums").as_integer());
+    }
+    if (server_section.contains("max_worker_nums")) {
+        _m_max_worker_nums = static_cast<int>(server_section.at("max_worker_nums").as_integer());
+    }
+    if (server_section.contains("autoscale_interval_ms")) {
+        _m_autoscale_interval_ms = static_cast<int>(server_section.at("autoscale_interval_ms").as_integer());
+    }
+    if (server_section.contains("autoscale_up_wait_ms")) {
+        _m_autoscale_up_wait_ms = static_cast<int>(server_section.at("autoscale_up_wait_ms").as_integer());
+    }
+    if (server_section.contains("autoscale_max_cpu_usage")) {
+        const auto& max_cpu_usage = server_section.at("autoscale_max_cpu_usage");
+        _m_autoscale_max_cpu_usage = max_cpu_usage.is_integer() ?
+                                     static_cast<double>(max_cpu_usage.as_integer()) : max_cpu_usage.as_floating();
+    }
+    if (server_section.contains("autoscale_cooldown_s")) {
+        _m_autoscale_cooldown_s = static_cast<int>(server_section.at("autoscale_cooldown_s").as_integer());
+    }
+    if (_m_enable_autoscaling) {
+        if (_m_min_worker_nums <= 0 || _m_max_worker_nums < _m_min_worker_nums || _m_autoscale_interval_ms <= 0) {
+            LOG(ERROR) << "invalid autoscaling params, min worker nums: " << _m_min_worker_nums
+                       << ", max worker nums: " << _m_max_worker_nums
+                       << ", interval: " << _m_autoscale_interval_ms << " ms";
+            return StatusCode::SERVER_INIT_FAILED;
+        }
+        start_autoscaler();
+        LOG(INFO) << "autoscaling enabled, worker nums: [" << _m_min_worker_nums << ", " << _m_max_worker_nums
+                  << "], scale up wait: " << _m_autoscale_up_wait_ms << " ms"
+                  << ", max cpu usage: " << _m_autoscale_max_cpu_usage
+                  << ", cooldown: " << _m_autoscale_cooldown_s << " s";
+    }
+
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param config
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::init_working_queue(const decltype(toml::parse(""))& config) {
+    std::vector<WORKER> workers;
+    if (create_workers(config, workers) != StatusCode::OK) {
+        LOG(ERROR) << "create model workers failed";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    for (auto& worker : workers) {
+        _m_working_queue.enqueue(std::move(worker));
+    }
+
+    // keep server config for reload
+    _m_server_config = config;
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::reload_workers() {
+    std::lock_guard<std::mutex> scaling_lock(_m_scaling_mutex);
+    auto reload_start_ts = Timestamp::now();
+
+    // build new workers while old ones keep serving
+    std::vector<WORKER> workers;
+    if (create_workers(_m_server_config, workers) != StatusCode::OK || workers.empty()) {
+        LOG(ERROR) << "reload model workers of: " << _m_server_uri << " failed, keep serving on old workers";
+        return StatusCode::SERVER_RUN_FAILED;
+    }
+    // model input size may have been changed as well
+    find_model_input_size(_m_server_config, _m_warm_up_image_size);
+    // old workers stay pinned until the new ones are swapped in, new ones take the blocks left free
+    if (_m_cpu_cores_per_worker > 0) {
+        assign_worker_cores(workers);
+    }
+    for (auto& worker : workers) {
+        if (warm_up_worker(worker, std::max(1, _m_warm_up_times)) != StatusCode::OK) {
+            LOG(ERROR) << "warm up new model worker of: " << _m_server_uri << " failed, keep serving on old workers";
+            std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+            for (const auto& new_worker : workers) {
+                _m_worker_cores.erase(static_cast<const void*>(&*new_worker));
+            }
+            return StatusCode::SERVER_RUN_FAILED;
+        }
+    }
+    auto worker_nums = workers.size();
+
+    // swap, busy old workers are dropped once their in-flight requests finish
+    if (_m_cpu_cores_per_worker > 0) {
+        retain_worker_cores(workers);
+    }
+    _m_working_queue.swap_workers(workers);
+    _m_worker_nums = static_cast<int>(worker_nums);
+    _m_reload_times++;
+    _m_result_cache_seed = make_result_cache_seed();
+    workers.clear();
+
+    LOG(INFO) << "reload " << worker_nums << " model workers of: " << _m_server_uri
+              << " successfully, cost: " << (Timestamp::now() - reload_start_ts) * 1000 << " ms"
+              << ", reload times: " << _m_reload_times;
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param worker
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::warm_up_worker(WORKER& worker, int warm_up_times) {
+    models::io_define::common_io::mat_input model_input;
+    model_input.input_image = cv::Mat(_m_warm_up_image_size, CV_8UC3, cv::Scalar(127, 127, 127));
+    ScopedCpuAffinity affinity(get_worker_cores(worker));
+    for (int index = 0; index < warm_up_times; ++index) {
+        MODEL_OUTPUT model_output;
+        auto status = worker->run(model_input, model_output);
+        if (status != StatusCode::OK) {
+            return status;
+        }
+    }
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::warm_up_workers() {
+    if (_m_warm_up_times <= 0) {
+        return StatusCode::OK;
+    }
+
+    std::vector<WORKER> workers;
+    WORKER worker;
+    while (_m_working_queue.try_dequeue(worker)) {
+        workers.push_back(std::move(worker));
+    }
+
+    auto warm_up_start_ts = Timestamp::now();
+    auto status = StatusCode::OK;
+    for (size_t index = 0; index < workers.size(); ++index) {
+        auto worker_start_ts = Timestamp::now();
+        status = warm_up_worker(workers[index], _m_warm_up_times);
+        if (status != StatusCode::OK) {
+            LOG(ERROR) << "warm up model worker " << index + 1 << " of: " << _m_server_uri << " failed";
+            break;
+        }
+        LOG(INFO) << "warm up model worker " << index + 1 << " of: " << _m_server_uri
+                  << ", runs: " << _m_warm_up_times
+                  << ", cost: " << (Timestamp::now() - worker_start_ts) * 1000 << " ms";
+    }
+    for (auto& warm_worker : workers) {
+        _m_working_queue.enqueue(std::move(warm_worker));
+    }
+    if (status == StatusCode::OK) {
+        LOG(INFO) << "warm up " << workers.size() << " model workers of: " << _m_server_uri
+                  << " with " << _m_warm_up_image_size.width << "x" << _m_warm_up_image_size.height
+                  << " image, cost: " << (Timestamp::now() - warm_up_start_ts) * 1000 << " ms";
+    }
+    return status;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::start_autoscaler() {
+    _m_autoscale_thread = std::thread([this]() {
+        CpuUsageSampler cpu_usage_sampler;
+        cpu_usage_sampler.sample();
+        auto last_pressure_ts = Timestamp::now();
+        std::unique_lock<std::mutex> lock(_m_autoscale_mutex);
+        while (!_m_autoscale_cv.wait_for(
+                lock, std::chrono::milliseconds(_m_autoscale_interval_ms), [this] { return _m_autoscale_stopped; })) {
+            lock.unlock();
+            autoscale_once(cpu_usage_sampler.sample(), last_pressure_ts);
+            lock.lock();
+        }
+    });
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::stop_autoscaler() {
+    {
+        std::lock_guard<std::mutex> lock(_m_autoscale_mutex);
+        _m_autoscale_stopped = true;
+    }
+    _m_autoscale_cv.notify_all();
+    if (_m_autoscale_thread.joinable()) {
+        _m_autoscale_thread.join();
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param cpu_usage
+ * @param last_pressure_ts
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::autoscale_once(double cpu_usage, Timestamp& last_pressure_ts) {
+    auto waiting_nums = _m_working_queue.waiting_nums();
+    auto recent_wait_ms = static_cast<double>(_m_recent_wait_us) / 1000.0;
+    auto now = Timestamp::now();
+
+    if (waiting_nums > 0 && recent_wait_ms >= _m_autoscale_up_wait_ms) {
+        last_pressure_ts = now;
+        if (_m_worker_nums >= _m_max_worker_nums) {
+            return;
+        }
+        // more workers only compete for cpu once it is saturated
+        if (cpu_usage >= 0.0 && cpu_usage >= _m_autoscale_max_cpu_usage) {
+            LOG(INFO) << "skip scaling up model workers of: " << _m_server_uri << ", cpu usage: " << cpu_usage;
+            return;
+        }
+        if (add_worker() == StatusCode::OK) {
+            _m_scale_ups++;
+            LOG(INFO) << "scale up model workers of: " << _m_server_uri << " to: " << _m_worker_nums
+                      << ", waiting requests: " << waiting_nums << ", recent wait: " << recent_wait_ms << " ms";
+        }
+        return;
+    }
+
+    if (waiting_nums > 0 || _m_working_queue.size_approx() == 0) {
+        last_pressure_ts = now;
+        return;
+    }
+    if (_m_worker_nums > _m_min_worker_nums && now - last_pressure_ts >= _m_autoscale_cooldown_s
+            && release_idle_worker()) {
+        _m_scale_downs++;
+        LOG(INFO) << "scale down model workers of: " << _m_server_uri << " to: " << _m_worker_nums;
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::add_worker() {
+    std::lock_guard<std::mutex> scaling_lock(_m_scaling_mutex);
+
+    // create exactly one worker with server config
+    auto config = _m_server_config;
+    for (auto& section : config.as_table()) {
+        if (section.second.is_table() && section.second.contains("server_url")
+                && section.second.at("server_url").as_string() == _m_server_uri) {
+            section.second.as_table()["worker_nums"] = 1;
+        }
+    }
+    std::vector<WORKER> workers;
+    if (create_workers(config, workers) != StatusCode::OK || workers.size() != 1) {
+        LOG(ERROR) << "create model worker of: " << _m_server_uri << " failed";
+        return StatusCode::SERVER_RUN_FAILED;
+    }
+    if (_m_cpu_cores_per_worker > 0) {
+        assign_worker_cores(workers);
+    }
+    if (warm_up_worker(workers[0], std::max(1, _m_warm_up_times)) != StatusCode::OK) {
+        LOG(ERROR) << "warm up model worker of: " << _m_server_uri << " failed";
+        std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+        _m_worker_cores.erase(static_cast<const void*>(&*workers[0]));
+        return StatusCode::SERVER_RUN_FAILED;
+    }
+
+    _m_working_queue.enqueue(std::move(workers[0]), _m_working_queue.generation());
+    _m_worker_nums++;
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::release_idle_worker() {
+    std::lock_guard<std::mutex> scaling_lock(_m_scaling_mutex);
+
+    WORKER worker;
+    if (!_m_working_queue.try_dequeue(worker)) {
+        return false;
+    }
+    _m_worker_nums--;
+    {
+        std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+        _m_worker_cores.erase(static_cast<const void*>(&*worker));
+    }
+    return true;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param workers
+ * @param first_index
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::assign_worker_cores(const std::vector<WORKER>& workers) {
+    auto cores = CpuAffinity::numa_ordered_cores();
+    if (cores.empty()) {
+        return;
+    }
+    auto core_nums = static_cast<int>(cores.size());
+    int block_nums = std::max(1, (core_nums - _m_cpu_core_offset) / _m_cpu_cores_per_worker);
+
+    // blocks of workers scaled down or still draining after reload may be held by any index
+    std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+    std::vector<int> free_blocks;
+    for (int index = 0; index < block_nums; ++index) {
+        auto block = CpuAffinity::worker_cores(cores, index, _m_cpu_cores_per_worker, _m_cpu_core_offset);
+        bool is_held = std::any_of(_m_worker_cores.begin(), _m_worker_cores.end(),
+            [&block](const std::pair<const void* const, std::vector<int>>& pinned) { return pinned.second == block; });
+        if (!is_held) {
+            free_blocks.push_back(index);
+        }
+    }
+    if (free_blocks.size() < workers.size()) {
+        LOG(WARNING) << "model workers of: " << _m_server_uri << " need more cores than the host has, cores are shared";
+    }
+
+    auto held_nums = _m_worker_cores.size();
+    for (size_t worker_index = 0; worker_index < workers.size(); ++worker_index) {
+        // wrap around into held blocks once no free block is left
+        int index = worker_index < free_blocks.size() ?
+                    free_blocks[worker_index] : static_cast<int>(held_nums + worker_index);
+        auto pinned_cores = CpuAffinity::worker_cores(cores, index, _m_cpu_cores_per_worker, _m_cpu_core_offset);
+        std::string core_list;
+        for (auto core : pinned_cores) {
+            core_list += (core_list.empty() ? "" : ",") + std::to_string(core);
+        }
+        LOG(INFO) << "pin model worker of: " << _m_server_uri << " to core block " << index << ", cores: " << core_list;
+        _m_worker_cores[static_cast<const void*>(&*workers[worker_index])] = std::move(pinned_cores);
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param workers
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::retain_worker_cores(const std::vector<WORKER>& workers) {
+    std::unordered_map<const void*, std::vector<int>> worker_cores;
+    std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+    for (const auto& worker : workers) {
+        auto it = _m_worker_cores.find(static_cast<const void*>(&*worker));
+        if (it != _m_worker_cores.end()) {
+            worker_cores.insert(*it);
+        }
+    }
+    _m_worker_cores.swap(worker_cores);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param worker
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+std::vector<int> BaseAiServerImpl<WORKER, MODEL_OUTPUT>::get_worker_cores(const WORKER& worker) {
+    if (_m_cpu_cores_per_worker <= 0) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(_m_worker_cores_mutex);
+    auto it = _m_worker_cores.find(static_cast<const void*>(&*worker));
+    return it == _m_worker_cores.end() ? std::vector<int>() : it->second;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param worker
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+int BaseAiServerImpl<WORKER, MODEL_OUTPUT>::get_worker_id(const WORKER& worker) {
+    std::lock_guard<std::mutex> lock(_m_worker_ids_mutex);
+    auto result = _m_worker_ids.emplace(static_cast<const void*>(&*worker), static_cast<int>(_m_worker_ids.size()));
+    return result.first->second;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param worker
+ * @param run_start_ts
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::trace_model_run(
+    BaseAiServerImpl::seriex_ctx* ctx, const WORKER& worker, const Timestamp& run_start_ts) {
+    if (_m_slow_request_sampler == nullptr) {
+        return;
+    }
+    ctx->model_run_time_consuming = (Timestamp::now() - run_start_ts) * 1000;
+    ctx->worker_id = get_worker_id(worker);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param status
+ * @param encode_time_consuming
+ * @param total_time_consuming
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::sample_slow_request(
+    BaseAiServerImpl::seriex_ctx* ctx, StatusCode status, double encode_time_consuming, double total_time_consuming) {
+    slow_request_record record;
+    record.server_uri = _m_server_uri;
+    record.task_id = ctx->task_id;
+    record.finished_ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+    record.status = static_cast<int32_t>(status);
+    record.worker_id = ctx->worker_id;
+    record.total_ms = total_time_consuming;
+    record.stage_ms = {
+        {"request_parse", ctx->parse_time_consuming},
+        {"image_decode", ctx->decode_time_consuming},
+        {"worker_wait", ctx->wait_worker_time_consuming},
+        {"model_run", ctx->model_run_time_consuming},
+        {"response_encode", encode_time_consuming},
+    };
+    record.raw_width = ctx->raw_width;
+    record.raw_height = ctx->raw_height;
+    record.raw_channels = ctx->raw_channels;
+    if (ctx->image_bytes != nullptr) {
+        record.image_data.assign(ctx->image_bytes, ctx->image_bytes_size);
+    }
+    _m_slow_request_sampler->offer(std::move(record));
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param config
+ * @param input_size
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::find_model_input_size(const toml::value& config, cv::Size& input_size) {
+    if (!config.is_table()) {
+        return false;
+    }
+    for (const auto& section : config.as_table()) {
+        if (!section.second.is_table() || !section.second.contains("model_config_file_path")) {
+            continue;
+        }
+        std::string model_cfg_path = section.second.at("model_config_file_path").as_string();
+        if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+            continue;
+        }
+        auto model_cfg = toml::parse(model_cfg_path);
+        for (const auto& model_section : model_cfg.as_table()) {
+            if (!model_section.second.is_table() || !model_section.second.contains("model_input_image_size")) {
+                continue;
+            }
+            // model input image size is configured as [height, width]
+            const auto& size = model_section.second.at("model_input_image_size").as_array();
+            if (size.size() != 2) {
+                continue;
+            }
+            input_size = cv::Size(static_cast<int>(size[1].as_integer()), static_cast<int>(size[0].as_integer()));
+            return true;
+        }
+    }
+    return false;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param config
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+int BaseAiServerImpl<WORKER, MODEL_OUTPUT>::find_model_threads_num(const toml::value& config) {
+    int threads_num = 0;
+    if (!config.is_table()) {
+        return threads_num;
+    }
+    for (const auto& section : config.as_table()) {
+        if (!section.second.is_table() || !section.second.contains("model_config_file_path")) {
+            continue;
+        }
+        std::string model_cfg_path = section.second.at("model_config_file_path").as_string();
+        if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+            continue;
+        }
+        auto model_cfg = toml::parse(model_cfg_path);
+        for (const auto& model_section : model_cfg.as_table()) {
+            if (!model_section.second.is_table() || !model_section.second.contains("model_file_path")) {
+                continue;
+            }
+            int model_threads_num = 4;
+            if (model_section.second.contains("model_threads_num")) {
+                model_threads_num = static_cast<int>(model_section.second.at("model_threads_num").as_integer());
+            }
+            threads_num = std::max(threads_num, model_threads_num);
+        }
+    }
+    return threads_num;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_INPUT
+ * @tparam MODEL_OUTPUT
+ * @param task
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::serve_process(WFHttpTask* task) {
+    // welcome message
+    if (strcmp(task->get_req()->get_request_uri(), "/welcome") == 0) {
+        task->get_resp()->append_output_body("<html>Welcome to jinq ai server</html>");
+        return;
+    }
+    // hello world message
+    else if (strcmp(task->get_req()->get_request_uri(), "/hello_world") == 0) {
+        task->get_resp()->append_output_body("<html>Hello World !!!</html>");
+        return;
+    }
+    // prometheus metrics
+    else if (strcmp(task->get_req()->get_request_uri(), "/metrics") == 0) {
+        task->get_resp()->add_header_pair("Content-Type", "text/plain; version=0.0.4");
+        task->get_resp()->append_output_body(make_metrics_body());
+        return;
+    }
+    // reload model workers, POST from clients on this host only
+    else if (_m_enable_admin && strcmp(task->get_req()->get_request_uri(), "/admin/reload") == 0) {
+        auto* resp = task->get_resp();
+        if (strcasecmp(task->get_req()->get_method(), "POST") != 0) {
+            resp->set_status_code("405");
+            resp->add_header_pair("Allow", "POST");
+            return;
+        }
+        if (!is_local_peer(get_peer_fd(task)) && !is_loopback_peer(get_peer_fd(task))) {
+            resp->set_status_code("403");
+            return;
+        }
+        if (_m_reloading.exchange(true)) {
+            resp->append_output_body(make_admin_response_body(StatusCode::SERVER_RUN_FAILED, "reload in progress"));
+            return;
+        }
+        auto* reload_task = WFTaskFactory::create_go_task("reload_" + _m_server_uri, [this, resp]() {
+            auto status = reload_workers();
+            resp->append_output_body(make_admin_response_body(status, status == StatusCode::OK ? "success" : "reload failed"));
+            _m_reloading = false;
+        });
+        *series_of(task) << reload_task;
+        return;
+    }
+    // model service
+    else if (strcmp(task->get_req()->get_request_uri(), _m_server_uri.c_str()) == 0) {
+        // init series work
+        auto* req = task->get_req();
+        auto* resp = task->get_resp();
+        auto* series = series_of(task);
+        if (!admit_request(resp)) {
+            return;
+        }
+        auto* ctx = new seriex_ctx;
+        ctx->response = resp;
+        ctx->series = series;
+        ctx->serve_start_ts = Timestamp::now();
+        ctx->tenant = find_tenant(req);
+        ctx->peer_fd = get_peer_fd(task);
+        series->set_context(ctx);
+        // parse request body
+        dispatch_task_request(series, ctx, parse_http_request(req, ctx));
+        return;
+    }
+    // batch model service
+    else if (strcmp(task->get_req()->get_request_uri(), (_m_server_uri + "/batch").c_str()) == 0) {
+        // admitted by item count once parsed
+        serve_batch_request(task);
+        return;
+    }
+    // not found valid url
+    else {
+        task->get_resp()->append_output_body("<html>404 Not Found</html>");
+        return;
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param task
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::serve_rpc_process(WFBinaryRpcTask* task) {
+    auto* resp = task->get_resp();
+    auto* series = series_of(task);
+    int64_t retry_after_ms = 0;
+    auto admission = check_admission(retry_after_ms);
+    if (admission != StatusCode::OK) {
+        resp->set_body(make_rpc_response_body("", admission, MODEL_OUTPUT()));
+        return;
+    }
+
+    auto* ctx = new seriex_ctx;
+    ctx->rpc_response = resp;
+    ctx->serve_start_ts = Timestamp::now();
+    ctx->peer_fd = get_peer_fd(task);
+    series->set_context(ctx);
+    dispatch_task_request(series, ctx, parse_rpc_request(task->get_req()));
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param series
+ * @param ctx
+ * @param task_req
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::dispatch_task_request(
+    SeriesWork* series,
+    BaseAiServerImpl::seriex_ctx* ctx,
+    BaseAiServerImpl::cls_request task_req) {
+    ctx->deadline = make_deadline(task_req);
+    ctx->parse_time_consuming = (Timestamp::now() - ctx->serve_start_ts) * 1000;
+    _m_stage_latency[STAGE_REQUEST_PARSE].observe(ctx->parse_time_consuming);
+    _m_waiting_jobs++;
+    _m_received_jobs++;
+    // do model work
+    if (_m_enable_batching || _m_enable_pipeline) {
+        ctx->task_id = task_req.task_id;
+        ctx->is_task_req_valid = task_req.is_valid;
+        ctx->task_received_ts = Timestamp::now();
+        ctx->request = std::move(task_req);
+    }
+    if (_m_enable_batching) {
+        // wait for the batch which carries this request
+        auto&& batch_cb = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_work_cb, this, std::placeholders::_1);
+        ctx->batch_counter = WFTaskFactory::create_counter_task(1, batch_cb);
+        *series << ctx->batch_counter;
+    } else if (_m_enable_pipeline) {
+        // decode -> infer -> encode, each stage on its own queue
+        auto* decode_task = WFTaskFactory::create_go_task(
+            _m_server_uri + "/decode", &BaseAiServerImpl<WORKER, MODEL_OUTPUT>::decode_stage, this, ctx);
+        ctx->infer_counter = WFTaskFactory::create_counter_task(1, nullptr);
+        auto* encode_task = WFTaskFactory::create_go_task(
+            _m_server_uri + "/encode", &BaseAiServerImpl<WORKER, MODEL_OUTPUT>::encode_stage, this, ctx);
+        *series << decode_task << ctx->infer_counter << encode_task;
+    } else {
+        auto&& go_proc = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work, this, std::placeholders::_1, std::placeholders::_2);
+        WFGoTask* serve_task = nullptr;
+        if (_m_model_run_timeout <= 0) {
+            serve_task = WFTaskFactory::create_go_task(_m_server_uri, go_proc, std::move(task_req), ctx);
+        } else {
+            serve_task = WFTaskFactory::create_timedgo_task(
+                0, _m_model_run_timeout * 1e6, _m_server_uri, go_proc, std::move(task_req), ctx);
+        }
+        auto&& go_proc_cb = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work_cb, this, serve_task);
+        serve_task->set_callback(go_proc_cb);
+        *series << serve_task;
+    }
+    ctx->release_counter = WFTaskFactory::create_counter_task(1, [](const WFCounterTask* task){
+        delete (seriex_ctx*)series_of(task)->get_context();
+    });
+    *series << ctx->release_counter;
+    // release counter must exist before the batch may be dispatched
+    if (_m_enable_batching) {
+        add_to_batch(ctx);
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param retry_after_ms
+ * @param job_nums
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::check_admission(int64_t& retry_after_ms, size_t job_nums) {
+    StatusCode status = StatusCode::OK;
+    retry_after_ms = 1000;
+
+    // jobs of the request are counted as if they were waiting already
+    size_t waiting_jobs = _m_waiting_jobs + job_nums - 1;
+    int64_t estimated_wait_ms = static_cast<int64_t>(
+        waiting_jobs * (_m_recent_run_us / 1000.0) / static_cast<double>(std::max(1, _m_worker_nums.load())));
+    if (_m_max_waiting_jobs >= 0 && waiting_jobs >= static_cast<size_t>(_m_max_waiting_jobs)) {
+        status = StatusCode::SERVER_OVERLOADED;
+        retry_after_ms = std::max(retry_after_ms, estimated_wait_ms);
+    } else if (_m_max_estimated_wait_ms >= 0 && estimated_wait_ms > _m_max_estimated_wait_ms) {
+        status = StatusCode::SERVER_OVERLOADED;
+        retry_after_ms = std::max(retry_after_ms, estimated_wait_ms - _m_max_estimated_wait_ms);
+    } else if (_m_rate_limiter != nullptr && !_m_rate_limiter->try_acquire(&retry_after_ms, job_nums)) {
+        status = StatusCode::SERVER_RATE_LIMITED;
+    }
+    if (status != StatusCode::OK) {
+        _m_rejected_jobs++;
+    }
+    return status;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param resp
+ * @param job_nums
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::admit_request(protocol::HttpResponse* resp, size_t job_nums) {
+    int64_t retry_after_ms = 0;
+    auto status = check_admission(retry_after_ms, job_nums);
+    if (status == StatusCode::OK) {
+        return true;
+    }
+
+    resp->set_status_code(status == StatusCode::SERVER_RATE_LIMITED ? "429" : "503");
+    resp->set_reason_phrase(status == StatusCode::SERVER_RATE_LIMITED ? "Too Many Requests" : "Service Unavailable");
+    resp->add_header_pair("Retry-After", std::to_string(std::max<int64_t>(1, (retry_after_ms + 999) / 1000)));
+    resp->append_output_body(make_admin_response_body(status, jinq::common::error_code_to_str(status)));
+    return false;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @param ctx
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+typename BaseAiServerImpl<WORKER, MODEL_OUTPUT>::cls_request BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_http_request(
+    protocol::HttpRequest* req,
+    BaseAiServerImpl::seriex_ctx* ctx) {
+
+    std::string content_type;
+    protocol::HttpHeaderCursor cursor(req);
+    cursor.find("Content-Type", content_type);
+    ctx->accept_gzip = is_gzip_accepted(req);
+    // deadline header takes precedence over the one in request body
+    int64_t header_deadline_ms = parse_deadline_header(req);
+    cursor.rewind();
+    auto task_req = parse_request_body(req, ctx, content_type, cursor);
+    if (header_deadline_ms >= 0) {
+        task_req.deadline_ms = header_deadline_ms;
+    }
+    return task_req;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+int64_t BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_deadline_header(protocol::HttpRequest* req) {
+    std::string deadline_header;
+    protocol::HttpHeaderCursor cursor(req);
+    if (cursor.find("X-Deadline-Ms", deadline_header)) {
+        return strtoll(deadline_header.c_str(), nullptr, 10);
+    }
+    return -1;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+size_t BaseAiServerImpl<WORKER, MODEL_OUTPUT>::find_tenant(protocol::HttpRequest* req) const {
+    if (_m_tenant_index.empty()) {
+        return 0;
+    }
+    std::string tenant_name;
+    protocol::HttpHeaderCursor cursor(req);
+    if (!cursor.find(_m_tenant_header, tenant_name)) {
+        return 0;
+    }
+    auto tenant = _m_tenant_index.find(tenant_name);
+    return tenant == _m_tenant_index.end() ? 0 : tenant->second;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+typename BaseAiServerImpl<WORKER, MODEL_OUTPUT>::cls_request BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_rpc_request(
+    BinaryRpcRequest* req) {
+    cls_request task_req{};
+    binary_rpc::rpc_request rpc_req;
+    if (!binary_rpc::parse_request_body(req->get_body(), rpc_req)) {
+        task_req.is_valid = false;
+        return task_req;
+    }
+    task_req.task_id = std::move(rpc_req.task_id);
+    task_req.deadline_ms = rpc_req.deadline_ms;
+    task_req.image_data = rpc_req.image_data;
+    task_req.image_data_size = rpc_req.image_data_size;
+    task_req.is_valid = !task_req.task_id.empty() && task_req.image_data_size > 0;
+    return task_req;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req_body
+ * @param req_body_size
+ * @param reqs
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_batch_task_request(
+    const char* req_body, size_t req_body_size, std::vector<cls_request>& reqs) {
+    if (req_body == nullptr) {
+        return false;
+    }
+    rapidjson::Document doc;
+    doc.Parse(req_body, req_body_size);
+    if (doc.HasParseError() || !doc.IsArray()) {
+        return false;
+    }
+
+    reqs.clear();
+    reqs.reserve(doc.Size());
+    for (const auto& item : doc.GetArray()) {
+        if (!item.IsObject()) {
+            return false;
+        }
+        cls_request req{};
+        if (!item.HasMember("img_data") || !item["img_data"].IsString()) {
+            req.is_valid = false;
+        } else {
+            req.image_content.assign(item["img_data"].GetString(), item["img_data"].GetStringLength());
+        }
+        if (!item.HasMember("req_id") || !item["req_id"].IsString()) {
+            req.is_valid = false;
+        } else {
+            req.task_id = item["req_id"].GetString();
+        }
+        if (item.HasMember("deadline_ms") && item["deadline_ms"].IsInt64()) {
+            req.deadline_ms = item["deadline_ms"].GetInt64();
+        }
+        reqs.push_back(std::move(req));
+    }
+    return true;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @param ctx
+ * @param content_type
+ * @param cursor
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+typename BaseAiServerImpl<WORKER, MODEL_OUTPUT>::cls_request BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_request_body(
+    protocol::HttpRequest* req,
+    BaseAiServerImpl::seriex_ctx* ctx,
+    const std::string& content_type,
+    protocol::HttpHeaderCursor& cursor) {
+
+    if (strncasecmp(content_type.c_str(), "application/x-mortred-shm", 25) == 0) {
+        // remote clients must not make the server map arbitrary segments of this host
+        if (!is_local_peer(ctx->peer_fd)) {
+            LOG(WARNING) << "shared memory request refused, it is served on local socket only";
+            cls_request task_req{};
+            task_req.is_valid = false;
+            return task_req;
+        }
+        return parse_shared_memory_request(ctx, cursor);
+    }
+    bool is_octet_stream = strncasecmp(content_type.c_str(), "application/octet-stream", 24) == 0
+                           || strncasecmp(content_type.c_str(), "image/", 6) == 0;
+    bool is_multipart = strncasecmp(content_type.c_str(), "multipart/form-data", 19) == 0;
+    // body is read in place unless it was chunked
+    const void* body = nullptr;
+    size_t body_size = 0;
+    if (req->is_chunked()) {
+        ctx->request_body = protocol::HttpUtil::decode_chunked_body(req);
+        body = ctx->request_body.data();
+        body_size = ctx->request_body.size();
+    } else {
+        req->get_parsed_body(&body, &body_size);
+    }
+    if (!is_octet_stream && !is_multipart) {
+        auto task_req = parse_task_request(static_cast<const char*>(body), body_size);
+        // image content was copied out of the body
+        std::string().swap(ctx->request_body);
+        return task_req;
+    }
+
+    cls_request task_req{};
+    if (is_octet_stream) {
+        task_req.is_valid = cursor.find("X-Req-Id", task_req.task_id) && body_size > 0;
+        task_req.image_data = static_cast<const char*>(body);
+        task_req.image_data_size = body_size;
+        return task_req;
+    }
+
+    MultipartReader reader(content_type);
+    if (!reader.parse(static_cast<const char*>(body), body_size)) {
+        task_req.is_valid = false;
+        return task_req;
+    }
+    auto* req_id_field = reader.find_field("req_id");
+    auto* image_field = reader.find_field("img_data");
+    auto* deadline_field = reader.find_field("deadline_ms");
+    if (req_id_field != nullptr) {
+        task_req.task_id = std::string(req_id_field->data, req_id_field->size);
+    }
+    if (deadline_field != nullptr) {
+        task_req.deadline_ms = strtoll(std::string(deadline_field->data, deadline_field->size).c_str(), nullptr, 10);
+    }
+    if (image_field != nullptr) {
+        task_req.image_data = image_field->data;
+        task_req.image_data_size = image_field->size;
+    }
+    task_req.is_valid = req_id_field != nullptr && image_field != nullptr && image_field->size > 0;
+    return task_req;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param cursor
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+typename BaseAiServerImpl<WORKER, MODEL_OUTPUT>::cls_request BaseAiServerImpl<WORKER, MODEL_OUTPUT>::parse_shared_memory_request(
+    BaseAiServerImpl::seriex_ctx* ctx,
+    protocol::HttpHeaderCursor& cursor) {
+
+    auto find_header = [&cursor](const char* name, std::string& value) {
+        cursor.rewind();
+        return cursor.find(name, value);
+    };
+    auto find_int_header = [&find_header](const char* name, int64_t default_value) {
+        std::string value;
+        return find_header(name, value) ? strtoll(value.c_str(), nullptr, 10) : default_value;
+    };
+
+    cls_request task_req{};
+    std::string shm_name;
+    task_req.is_valid = find_header("X-Req-Id", task_req.task_id) && find_header("X-Shm-Name", shm_name);
+    int64_t offset = find_int_header("X-Shm-Offset", 0);
+    int64_t size = find_int_header("X-Shm-Size", 0);
+    if (!task_req.is_valid || offset < 0 || size <= 0) {
+        task_req.is_valid = false;
+        return task_req;
+    }
+
+    // raw pixels need all of width, height and channels
+    int64_t width = find_int_header("X-Image-Width", 0);
+    int64_t height = find_int_header("X-Image-Height", 0);
+    int64_t channels = find_int_header("X-Image-Channels", 0);
+    if (width > 0 || height > 0 || channels > 0) {
+        if (width <= 0 || height <= 0 || (channels != 1 && channels != 3) || width * height * channels != size) {
+            task_req.is_valid = false;
+            return task_req;
+        }
+        task_req.raw_width = static_cast<int>(width);
+        task_req.raw_height = static_cast<int>(height);
+        task_req.raw_channels = static_cast<int>(channels);
+    }
+
+    ctx->shared_memory = std::make_unique<SharedMemoryRegion>();
+    if (!ctx->shared_memory->open(shm_name, static_cast<size_t>(offset), static_cast<size_t>(size))) {
+        LOG(WARNING) << "task: " << task_req.task_id << " can not map shared memory: " << shm_name
+                     << ", offset: " << offset << ", size: " << size;
+        ctx->shared_memory.reset();
+        task_req.is_valid = false;
+        return task_req;
+    }
+    task_req.image_data = ctx->shared_memory->data();
+    task_req.image_data_size = ctx->shared_memory->size();
+    return task_req;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @param image
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::load_image_bytes(
+    const cls_request& req, std::string& buffer, const char*& data, size_t& size) {
+    if (req.image_data != nullptr) {
+        // binary body is used in place
+        data = req.image_data;
+        size = req.image_data_size;
+    } else {
+        auto base64_start_ts = Timestamp::now();
+        Base64::base64_decode(req.image_content.data(), req.image_content.size(), buffer);
+        _m_stage_latency[STAGE_BASE64_DECODE].observe((Timestamp::now() - base64_start_ts) * 1000);
+        data = buffer.data();
+        size = buffer.size();
+    }
+    return size > 0;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param data
+ * @param size
+ * @param image
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::decode_image(const char* data, size_t size, cv::Mat& image) {
+    // wrap image bytes without copy
+    auto decode_start_ts = Timestamp::now();
+    cv::Mat image_buffer(1, static_cast<int>(size), CV_8UC1, const_cast<char*>(data));
+    image = cv::imdecode(image_buffer, cv::IMREAD_UNCHANGED);
+    _m_stage_latency[STAGE_IMAGE_DECODE].observe((Timestamp::now() - decode_start_ts) * 1000);
+    return !image.empty();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param data
+ * @param size
+ * @param seed_mix
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::lookup_result_cache(
+    seriex_ctx* ctx, const char* data, size_t size, uint64_t seed_mix) {
+    if (!_m_enable_result_cache && !_m_enable_request_coalescing) {
+        return false;
+    }
+    ctx->cache_key = jinq::common::hash_util::murmur_hash64(data, size, _m_result_cache_seed ^ seed_mix);
+    ctx->has_cache_key = true;
+    // cached json responses are of no use to binary rpc requests
+    return _m_enable_result_cache && ctx->rpc_response == nullptr
+           && _m_result_cache->get(ctx->cache_key, ctx->cached_response);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @param ctx
+ * @param model_input
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::prepare_model_input(
+    const cls_request& req, seriex_ctx* ctx, models::io_define::common_io::mat_input& model_input) {
+    auto decode_start_ts = Timestamp::now();
+    std::string image_bytes_buffer;
+    const char* image_bytes = nullptr;
+    size_t image_bytes_size = 0;
+
+    if (!load_image_bytes(req, image_bytes_buffer, image_bytes, image_bytes_size)) {
+        ctx->model_run_status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+        return false;
+    }
+    if (_m_slow_request_sampler != nullptr) {
+        // keep decoded base64 bytes for capture, binary body and shared memory outlive the response anyway
+        if (image_bytes == image_bytes_buffer.data()) {
+            ctx->image_bytes_buffer.swap(image_bytes_buffer);
+            image_bytes = ctx->image_bytes_buffer.data();
+        }
+        ctx->image_bytes = image_bytes;
+        ctx->image_bytes_size = image_bytes_size;
+        ctx->raw_width = req.raw_width;
+        ctx->raw_height = req.raw_height;
+        ctx->raw_channels = req.raw_channels;
+    }
+    if (req.raw_width > 0) {
+        // same pixels with another shape is another image
+        uint64_t shape = (static_cast<uint64_t>(req.raw_width) << 32) | (static_cast<uint64_t>(req.raw_height) << 4)
+                         | static_cast<uint64_t>(req.raw_channels);
+        if (lookup_result_cache(ctx, image_bytes, image_bytes_size, shape)) {
+            ctx->model_run_status = StatusCode::OK;
+            return false;
+        }
+        // wrap mapped pixels without copy, the mapping lives as long as ctx
+        model_input.input_image = cv::Mat(
+            req.raw_height, req.raw_width, CV_8UC(req.raw_channels), const_cast<char*>(image_bytes));
+        ctx->decode_time_consuming = (Timestamp::now() - decode_start_ts) * 1000;
+        return true;
+    }
+    if (lookup_result_cache(ctx, image_bytes, image_bytes_size)) {
+        ctx->model_run_status = StatusCode::OK;
+        return false;
+    }
+    if (!decode_image(image_bytes, image_bytes_size, model_input.input_image)) {
+        ctx->model_run_status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+        return false;
+    }
+    ctx->decode_time_consuming = (Timestamp::now() - decode_start_ts) * 1000;
+    return true;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+typename WorkerPool<WORKER>::time_point BaseAiServerImpl<WORKER, MODEL_OUTPUT>::make_deadline(
+    const cls_request& req) const {
+    auto now = WorkerPool<WORKER>::clock_type::now();
+    auto deadline = WorkerPool<WORKER>::time_point::max();
+
+    if (req.deadline_ms >= 0) {
+        deadline = now + std::chrono::milliseconds(req.deadline_ms);
+    }
+    // client has got timeout response once model run timeout, no need to run it any more. Batches have no
+    // timed task of their own, they fail requests past it instead of running them
+    if (_m_model_run_timeout > 0) {
+        deadline = std::min(deadline, now + std::chrono::milliseconds(_m_model_run_timeout));
+    }
+    return deadline;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @tparam MODEL_INPUT
+ * @param worker
+ * @param input
+ * @param output
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+template<typename MODEL_INPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::run_worker(
+    WORKER& worker, const MODEL_INPUT& input, MODEL_OUTPUT& output) {
+    ScopedCpuAffinity affinity(get_worker_cores(worker));
+    _m_busy_workers++;
+    auto run_start_ts = Timestamp::now();
+    auto status = worker->run(input, output);
+    observe_worker_run(run_start_ts);
+    return status;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param run_start_ts
+ * @param input_nums
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::observe_worker_run(const Timestamp& run_start_ts, size_t input_nums) {
+    auto run_time_consuming = (Timestamp::now() - run_start_ts) * 1000;
+    _m_busy_workers--;
+
+    _m_worker_busy_us += static_cast<uint64_t>(run_time_consuming * 1000);
+    _m_stage_latency[STAGE_MODEL_RUN].observe(run_time_consuming);
+    update_moving_average(_m_recent_run_us, run_time_consuming / static_cast<double>(input_nums));
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+std::string BaseAiServerImpl<WORKER, MODEL_OUTPUT>::make_metrics_body() {
+    static const char* stage_names[STAGE_NUMS] = {
+        "request_parse", "base64_decode", "image_decode", "worker_wait", "model_run", "response_encode", "total"
+    };
+    std::string server_label = "server=\"" + _m_server_uri + "\"";
+    std::string metrics_body;
+
+    metrics_body += "# HELP mortred_server_stage_latency_milliseconds latency of each serving stage\n";
+    metrics_body += "# TYPE mortred_server_stage_latency_milliseconds histogram\n";
+    for (int stage = 0; stage < STAGE_NUMS; ++stage) {
+        auto labels = server_label + ",stage=\"" + stage_names[stage] + "\"";
+        _m_stage_latency[stage].to_prometheus("mortred_server_stage_latency_milliseconds", labels, metrics_body);
+    }
+
+    size_t busy_workers = _m_busy_workers;
+    size_t idle_workers = _m_working_queue.size_approx();
+    double worker_utilization = busy_workers + idle_workers == 0 ?
+                                0.0 : static_cast<double>(busy_workers) / static_cast<double>(busy_workers + idle_workers);
+    std::ostringstream oss;
+    oss << "# TYPE mortred_server_received_jobs_total counter\n"
+        << "mortred_server_received_jobs_total{" << server_label << "} " << _m_received_jobs << "\n"
+        << "# TYPE mortred_server_finished_jobs_total counter\n"
+        << "mortred_server_finished_jobs_total{" << server_label << "} " << _m_finished_jobs << "\n"
+        << "# TYPE mortred_server_expired_jobs_total counter\n"
+        << "mortred_server_expired_jobs_total{" << server_label << "} " << _m_expired_jobs << "\n"
+        << "# TYPE mortred_server_cancelled_jobs_total counter\n"
+        << "mortred_server_cancelled_jobs_total{" << server_label << "} " << _m_cancelled_jobs << "\n"
+        << "# TYPE mortred_server_compressed_responses_total counter\n"
+        << "mortred_server_compressed_responses_total{" << server_label << "} " << _m_compressed_responses << "\n"
+        << "# TYPE mortred_server_compression_saved_bytes_total counter\n"
+        << "mortred_server_compression_saved_bytes_total{" << server_label << "} " << _m_compression_saved_bytes << "\n"
+        << "# TYPE mortred_server_inflight_jobs gauge\n"
+        << "mortred_server_inflight_jobs{" << server_label << "} " << _m_waiting_jobs << "\n"
+        << "# TYPE mortred_server_worker_waiters gauge\n"
+        << "mortred_server_worker_waiters{" << server_label << "} " << _m_working_queue.waiting_nums() << "\n"
+        << "# TYPE mortred_server_busy_workers gauge\n"
+        << "mortred_server_busy_workers{" << server_label << "} " << busy_workers << "\n"
+        << "# TYPE mortred_server_idle_workers gauge\n"
+        << "mortred_server_idle_workers{" << server_label << "} " << idle_workers << "\n"
+        << "# TYPE mortred_server_worker_utilization gauge\n"
+        << "mortred_server_worker_utilization{" << server_label << "} " << worker_utilization << "\n"
+        << "# TYPE mortred_server_worker_busy_seconds_total counter\n"
+        << "mortred_server_worker_busy_seconds_total{" << server_label << "} "
+        << static_cast<double>(_m_worker_busy_us) / Timestamp::k_micro_sec_per_sec << "\n"
+        << "# TYPE mortred_server_worker_reloads_total counter\n"
+        << "mortred_server_worker_reloads_total{" << server_label << "} " << _m_reload_times << "\n"
+        << "# TYPE mortred_server_workers gauge\n"
+        << "mortred_server_workers{" << server_label << "} " << _m_worker_nums << "\n"
+        << "# TYPE mortred_server_worker_scale_ups_total counter\n"
+        << "mortred_server_worker_scale_ups_total{" << server_label << "} " << _m_scale_ups << "\n"
+        << "# TYPE mortred_server_worker_scale_downs_total counter\n"
+        << "mortred_server_worker_scale_downs_total{" << server_label << "} " << _m_scale_downs << "\n"
+        << "# TYPE mortred_server_rejected_jobs_total counter\n"
+        << "mortred_server_rejected_jobs_total{" << server_label << "} " << _m_rejected_jobs << "\n";
+    if (_m_enable_request_coalescing) {
+        oss << "# TYPE mortred_server_coalesced_jobs_total counter\n"
+            << "mortred_server_coalesced_jobs_total{" << server_label << "} " << _m_coalesced_jobs << "\n";
+    }
+    if (_m_enable_pipeline) {
+        oss << "# TYPE mortred_server_inference_queued_jobs gauge\n"
+            << "mortred_server_inference_queued_jobs{" << server_label << "} " << _m_inference_pool->queued_nums() << "\n";
+    }
+    if (_m_enable_result_cache) {
+        oss << "# TYPE mortred_server_result_cache_hits_total counter\n"
+            << "mortred_server_result_cache_hits_total{" << server_label << "} " << _m_result_cache->hits() << "\n"
+            << "# TYPE mortred_server_result_cache_misses_total counter\n"
+            << "mortred_server_result_cache_misses_total{" << server_label << "} " << _m_result_cache->misses() << "\n"
+            << "# TYPE mortred_server_result_cache_entries gauge\n"
+            << "mortred_server_result_cache_entries{" << server_label << "} " << _m_result_cache->size() << "\n"
+            << "# TYPE mortred_server_result_cache_bytes gauge\n"
+            << "mortred_server_result_cache_bytes{" << server_label << "} " << _m_result_cache->bytes() << "\n";
+    }
+    metrics_body += oss.str();
+
+    if (!_m_tenant_index.empty()) {
+        std::ostringstream tenant_oss;
+        tenant_oss << "# TYPE mortred_server_tenant_waiting_jobs gauge\n";
+        for (size_t index = 0; index < _m_tenant_names.size(); ++index) {
+            tenant_oss << "mortred_server_tenant_waiting_jobs{" << server_label << ",tenant=\"" << _m_tenant_names[index]
+                       << "\"} " << _m_working_queue.get_tenant_stat(index).waiting << "\n";
+        }
+        tenant_oss << "# TYPE mortred_server_tenant_running_jobs gauge\n";
+        for (size_t index = 0; index < _m_tenant_names.size(); ++index) {
+            tenant_oss << "mortred_server_tenant_running_jobs{" << server_label << ",tenant=\"" << _m_tenant_names[index]
+                       << "\"} " << _m_working_queue.get_tenant_stat(index).running << "\n";
+        }
+        tenant_oss << "# TYPE mortred_server_tenant_served_jobs_total counter\n";
+        for (size_t index = 0; index < _m_tenant_names.size(); ++index) {
+            tenant_oss << "mortred_server_tenant_served_jobs_total{" << server_label << ",tenant=\"" << _m_tenant_names[index]
+                       << "\"} " << _m_working_queue.get_tenant_stat(index).served << "\n";
+        }
+        metrics_body += tenant_oss.str();
+        metrics_body += "# TYPE mortred_server_tenant_worker_wait_milliseconds histogram\n";
+        for (size_t index = 0; index < _m_tenant_names.size(); ++index) {
+            auto labels = server_label + ",tenant=\"" + _m_tenant_names[index] + "\"";
+            _m_tenant_wait_latency[index]->to_prometheus("mortred_server_tenant_worker_wait_milliseconds", labels, metrics_body);
+        }
+    }
+
+    return metrics_body;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_INPUT
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work(
+    const BaseAiServerImpl::cls_request& req,
+    BaseAiServerImpl::seriex_ctx* ctx) {
+
+    // get task receive timestamp
+    ctx->task_id = req.task_id;
+    ctx->is_task_req_valid = req.is_valid;
+    auto task_receive_ts = Timestamp::now();
+    ctx->task_received_ts = task_receive_ts;
+
+    // decode image before holding a worker
+    models::io_define::common_io::mat_input model_input;
+    StatusCode status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+
+    if (req.is_valid && is_expired(ctx)) {
+        // drop expired request before doing any work for it
+        status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+    } else if (req.is_valid && is_cancelled(ctx)) {
+        status = StatusCode::MODEL_RUN_CANCELLED;
+    } else if (req.is_valid && !prepare_model_input(req, ctx, model_input)) {
+        // invalid image or result cache hit
+        status = ctx->model_run_status;
+    } else if (req.is_valid) {
+        status = infer_on_worker(model_input, ctx);
+    }
+
+    // update ctx
+    finish_model_run(ctx, status, task_receive_ts);
+    ctx->release_counter->count();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param model_input
+ * @param ctx
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::infer_on_worker(
+    const models::io_define::common_io::mat_input& model_input,
+    BaseAiServerImpl::seriex_ctx* ctx) {
+    if (!_m_enable_request_coalescing || !ctx->has_cache_key) {
+        return hold_worker_and_run(model_input, ctx);
+    }
+
+    // join the in-flight run of identical image or start a new one
+    std::shared_ptr<inflight_run> run;
+    bool is_leader = false;
+    {
+        std::lock_guard<std::mutex> lock(_m_inflight_mutex);
+        auto& inflight = _m_inflight_runs[ctx->cache_key];
+        if (inflight == nullptr) {
+            inflight = std::make_shared<inflight_run>();
+            is_leader = true;
+        }
+        run = inflight;
+    }
+
+    if (!is_leader) {
+        _m_coalesced_jobs++;
+        auto wait_start_ts = Timestamp::now();
+        std::unique_lock<std::mutex> lock(run->mutex);
+        bool finished = true;
+        if (ctx->deadline == WorkerPool<WORKER>::time_point::max()) {
+            run->cv.wait(lock, [&run] { return run->finished; });
+        } else {
+            finished = run->cv.wait_until(lock, ctx->deadline, [&run] { return run->finished; });
+        }
+        ctx->wait_worker_time_consuming = (Timestamp::now() - wait_start_ts) * 1000;
+        if (!finished) {
+            return StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+        }
+        // leader gave up for its own deadline or client, run it again if this request still has time left
+        if ((run->status == StatusCode::MODEL_RUN_DEADLINE_EXCEEDED || run->status == StatusCode::MODEL_RUN_CANCELLED)
+            && !is_expired(ctx)) {
+            lock.unlock();
+            return infer_on_worker(model_input, ctx);
+        }
+        ctx->model_output = run->model_output;
+        return run->status;
+    }
+
+    auto status = hold_worker_and_run(model_input, ctx);
+    {
+        std::lock_guard<std::mutex> lock(_m_inflight_mutex);
+        _m_inflight_runs.erase(ctx->cache_key);
+    }
+    {
+        std::lock_guard<std::mutex> lock(run->mutex);
+        run->status = status;
+        run->model_output = ctx->model_output;
+        run->finished = true;
+    }
+    run->cv.notify_all();
+    return status;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param model_input
+ * @param ctx
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::hold_worker_and_run(
+    const models::io_define::common_io::mat_input& model_input,
+    BaseAiServerImpl::seriex_ctx* ctx) {
+    WORKER worker;
+    size_t worker_generation = 0;
+    auto status = acquire_worker(ctx, worker, worker_generation);
+    if (status != StatusCode::OK) {
+        return status;
+    }
+
+    // do model inference
+    auto run_start_ts = Timestamp::now();
+    status = run_worker(worker, model_input, ctx->model_output);
+    trace_model_run(ctx, worker, run_start_ts);
+
+    if (status != StatusCode::OK) {
+        LOG(ERROR) << "worker run failed";
+    }
+
+    // restore worker queue
+    _m_working_queue.enqueue(std::move(worker), worker_generation, ctx->tenant);
+    return status;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param worker
+ * @param worker_generation
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+StatusCode BaseAiServerImpl<WORKER, MODEL_OUTPUT>::acquire_worker(
+    BaseAiServerImpl::seriex_ctx* ctx, WORKER& worker, size_t& worker_generation) {
+    // get model worker, give up once deadline passed
+    auto wait_worker_start_ts = Timestamp::now();
+    bool got_worker = _m_working_queue.dequeue(worker, ctx->deadline, &worker_generation, ctx->tenant);
+
+    ctx->wait_worker_time_consuming = (Timestamp::now() - wait_worker_start_ts) * 1000;
+    _m_stage_latency[STAGE_WORKER_WAIT].observe(ctx->wait_worker_time_consuming);
+    _m_tenant_wait_latency[ctx->tenant]->observe(ctx->wait_worker_time_consuming);
+    update_moving_average(_m_recent_wait_us, ctx->wait_worker_time_consuming);
+
+    if (!got_worker) {
+        return StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+    }
+    // client may have gone while waiting, hand the worker on without running
+    if (is_cancelled(ctx)) {
+        _m_working_queue.enqueue(std::move(worker), worker_generation, ctx->tenant);
+        return StatusCode::MODEL_RUN_CANCELLED;
+    }
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::submit_on_worker(BaseAiServerImpl::seriex_ctx* ctx) {
+    WORKER worker;
+    size_t worker_generation = 0;
+    auto status = acquire_worker(ctx, worker, worker_generation);
+    if (status != StatusCode::OK) {
+        ctx->model_input.input_image.release();
+        finish_model_run(ctx, status, ctx->serve_start_ts);
+        ctx->infer_counter->count();
+        return;
+    }
+
+    // ctx may be released inside run_async once done was invoked
+    auto tenant = ctx->tenant;
+    {
+        ScopedCpuAffinity affinity(get_worker_cores(worker));
+        _m_busy_workers++;
+        auto run_start_ts = Timestamp::now();
+        auto worker_id = _m_slow_request_sampler != nullptr ? get_worker_id(worker) : -1;
+        worker->run_async(ctx->model_input, [this, ctx, run_start_ts, worker_id](StatusCode run_status, MODEL_OUTPUT& output) {
+            if (run_status != StatusCode::OK) {
+                LOG(ERROR) << "worker run failed";
+            }
+            // model run is over once its post-process is done, not when the worker was handed back
+            observe_worker_run(run_start_ts);
+            ctx->model_run_time_consuming = (Timestamp::now() - run_start_ts) * 1000;
+            ctx->worker_id = worker_id;
+            ctx->model_output = std::move(output);
+            ctx->model_input.input_image.release();
+            finish_model_run(ctx, run_status, ctx->serve_start_ts);
+            ctx->infer_counter->count();
+        });
+    }
+
+    // restore worker queue
+    _m_working_queue.enqueue(std::move(worker), worker_generation, tenant);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param status
+ * @param task_receive_ts
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::finish_model_run(
+    BaseAiServerImpl::seriex_ctx* ctx, StatusCode status, const Timestamp& task_receive_ts) {
+    if (status == StatusCode::MODEL_RUN_DEADLINE_EXCEEDED) {
+        _m_expired_jobs++;
+        LOG(WARNING) << "task: " << ctx->task_id << " dropped since deadline exceeded";
+    } else if (status == StatusCode::MODEL_RUN_CANCELLED) {
+        _m_cancelled_jobs++;
+        LOG(WARNING) << "task: " << ctx->task_id << " dropped since client cancelled";
+    }
+    ctx->model_run_status = status;
+
+    auto task_finish_ts = Timestamp::now();
+    ctx->task_finished_ts = task_finish_ts;
+    ctx->worker_run_time_consuming = (task_finish_ts - task_receive_ts) * 1000;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::decode_stage(BaseAiServerImpl::seriex_ctx* ctx) {
+    StatusCode status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+
+    if (ctx->is_task_req_valid && is_expired(ctx)) {
+        status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+    } else if (ctx->is_task_req_valid && is_cancelled(ctx)) {
+        status = StatusCode::MODEL_RUN_CANCELLED;
+    } else if (ctx->is_task_req_valid && !prepare_model_input(ctx->request, ctx, ctx->model_input)) {
+        // invalid image or result cache hit
+        status = ctx->model_run_status;
+    } else if (ctx->is_task_req_valid) {
+        // request buffer is not needed any more once image was decoded
+        std::string().swap(ctx->request.image_content);
+        _m_inference_pool->submit([this, ctx]() { infer_stage(ctx); }, ctx->deadline);
+        return;
+    }
+
+    finish_model_run(ctx, status, ctx->serve_start_ts);
+    ctx->infer_counter->count();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::infer_stage(BaseAiServerImpl::seriex_ctx* ctx) {
+    StatusCode status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+    if (is_cancelled(ctx)) {
+        status = StatusCode::MODEL_RUN_CANCELLED;
+    } else if (!is_expired(ctx) && (!_m_enable_request_coalescing || !ctx->has_cache_key)) {
+        // inference thread is freed once the model takes the next input, not when output is ready
+        submit_on_worker(ctx);
+        return;
+    } else if (!is_expired(ctx)) {
+        status = infer_on_worker(ctx->model_input, ctx);
+    }
+    ctx->model_input.input_image.release();
+
+    finish_model_run(ctx, status, ctx->serve_start_ts);
+    ctx->infer_counter->count();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::encode_stage(BaseAiServerImpl::seriex_ctx* ctx) {
+    fill_response(ctx, ctx->model_run_status);
+    ctx->release_counter->count();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_INPUT
+ * @tparam MODEL_OUTPUT
+ * @param task
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_work_cb(const WFGoTask* task) {
+    auto state = task->get_state();
+    auto* ctx = (seriex_ctx*)series_of(task)->get_context();
+
+    // fill response
+    StatusCode status;
+
+    if (state != WFT_STATE_SUCCESS) {
+        LOG(ERROR) << "task: " << ctx->task_id << " model run timeout";
+        status = StatusCode::MODEL_RUN_TIMEOUT;
+        // response is sent without result, go task still waiting for a worker should give up
+        ctx->cancelled = true;
+    } else {
+        status = ctx->model_run_status;
+    }
+
+    fill_response(ctx, status);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param batch
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_work(const std::vector<seriex_ctx*>& batch) {
+    auto batch_start_ts = Timestamp::now();
+
+    // decode images before holding a worker
+    std::vector<models::io_define::common_io::mat_input> model_inputs;
+    std::vector<seriex_ctx*> valid_ctxs;
+    auto batch_deadline = WorkerPool<WORKER>::time_point::min();
+    for (auto* ctx : batch) {
+        models::io_define::common_io::mat_input model_input;
+        if (ctx->is_task_req_valid && is_expired(ctx)) {
+            ctx->model_run_status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+            _m_expired_jobs++;
+        } else if (ctx->is_task_req_valid && is_cancelled(ctx)) {
+            ctx->model_run_status = StatusCode::MODEL_RUN_CANCELLED;
+            _m_cancelled_jobs++;
+        } else if (!ctx->is_task_req_valid) {
+            ctx->model_run_status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+        } else if (prepare_model_input(ctx->request, ctx, model_input)) {
+            model_inputs.push_back(std::move(model_input));
+            valid_ctxs.push_back(ctx);
+            batch_deadline = std::max(batch_deadline, ctx->deadline);
+        }
+        std::string().swap(ctx->request.image_content);
+    }
+
+    // do model inference with one invocation, fall back to run one by one if batch failed
+    double wait_worker_time_consuming = 0;
+    WORKER worker;
+    size_t worker_generation = 0;
+    bool got_worker = false;
+    if (!model_inputs.empty()) {
+        // get model worker, batch gives up only when all its requests expired
+        auto wait_worker_start_ts = Timestamp::now();
+        got_worker = _m_working_queue.dequeue(worker, batch_deadline, &worker_generation);
+
+        wait_worker_time_consuming = (Timestamp::now() - wait_worker_start_ts) * 1000;
+        _m_stage_latency[STAGE_WORKER_WAIT].observe(wait_worker_time_consuming);
+        update_moving_average(_m_recent_wait_us, wait_worker_time_consuming);
+
+        // drop requests expired or cancelled while waiting for worker
+        std::vector<models::io_define::common_io::mat_input> live_inputs;
+        std::vector<seriex_ctx*> live_ctxs;
+        for (size_t idx = 0; idx < valid_ctxs.size(); ++idx) {
+            if (!got_worker || is_expired(valid_ctxs[idx])) {
+                valid_ctxs[idx]->model_run_status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+                _m_expired_jobs++;
+            } else if (is_cancelled(valid_ctxs[idx])) {
+                valid_ctxs[idx]->model_run_status = StatusCode::MODEL_RUN_CANCELLED;
+                _m_cancelled_jobs++;
+            } else {
+                live_inputs.push_back(std::move(model_inputs[idx]));
+                live_ctxs.push_back(valid_ctxs[idx]);
+            }
+        }
+        model_inputs.swap(live_inputs);
+        valid_ctxs.swap(live_ctxs);
+    }
+    if (!model_inputs.empty()) {
+        ScopedCpuAffinity affinity(get_worker_cores(worker));
+        _m_busy_workers++;
+        auto run_start_ts = Timestamp::now();
+        std::vector<MODEL_OUTPUT> model_outputs;
+        auto status = worker->run_batch(model_inputs, model_outputs);
+        observe_worker_run(run_start_ts, model_inputs.size());
+        for (auto* ctx : valid_ctxs) {
+            trace_model_run(ctx, worker, run_start_ts);
+        }
+
+        if (status == StatusCode::OK && model_outputs.size() == model_inputs.size()) {
+            for (size_t idx = 0; idx < valid_ctxs.size(); ++idx) {
+                valid_ctxs[idx]->model_output = std::move(model_outputs[idx]);
+                valid_ctxs[idx]->model_run_status = StatusCode::OK;
+            }
+        } else {
+            LOG(WARNING) << "worker run batch failed, fall back to run requests one by one";
+            for (size_t idx = 0; idx < valid_ctxs.size(); ++idx) {
+                run_start_ts = Timestamp::now();
+                status = run_worker(worker, model_inputs[idx], valid_ctxs[idx]->model_output);
+                trace_model_run(valid_ctxs[idx], worker, run_start_ts);
+                if (status != StatusCode::OK) {
+                    LOG(ERROR) << "worker run failed";
+                }
+                valid_ctxs[idx]->model_run_status = status;
+            }
+        }
+    }
+    if (got_worker) {
+        // restore worker queue
+        _m_working_queue.enqueue(std::move(worker), worker_generation);
+    }
+
+    // scatter results back into each request's series
+    auto batch_finish_ts = Timestamp::now();
+    auto task_finished_ts = batch_finish_ts;
+    auto worker_run_time_consuming = (batch_finish_ts - batch_start_ts) * 1000;
+    for (auto* ctx : batch) {
+        ctx->task_finished_ts = task_finished_ts;
+        ctx->worker_run_time_consuming = worker_run_time_consuming;
+        ctx->wait_worker_time_consuming = wait_worker_time_consuming;
+        ctx->batch_size = batch.size();
+        auto* batch_counter = ctx->batch_counter;
+        auto* release_counter = ctx->release_counter;
+        batch_counter->count();
+        release_counter->count();
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param task
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_work_cb(const WFCounterTask* task) {
+    auto* ctx = (seriex_ctx*)series_of(task)->get_context();
+    fill_response(ctx, ctx->model_run_status);
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::add_to_batch(seriex_ctx* ctx) {
+    std::vector<seriex_ctx*> batch;
+    bool start_timer = false;
+    size_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(_m_batch_mutex);
+        _m_pending_batch.push_back(ctx);
+
+        if (_m_pending_batch.size() >= static_cast<size_t>(_m_max_batch_size)) {
+            batch.swap(_m_pending_batch);
+            _m_batch_generation++;
+        } else if (_m_pending_batch.size() == 1) {
+            start_timer = true;
+            generation = _m_batch_generation;
+        }
+    }
+
+    if (!batch.empty()) {
+        dispatch_batch(std::move(batch));
+    } else if (start_timer) {
+        // first request of a new batch opens the batch delay window
+        auto* timer = WFTaskFactory::create_timer_task(
+            static_cast<unsigned int>(_m_max_batch_delay_ms) * 1000, [this, generation](WFTimerTask*) {
+                flush_batch(generation);
+            });
+        timer->start();
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param generation
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::flush_batch(size_t generation) {
+    std::vector<seriex_ctx*> batch;
+    {
+        std::lock_guard<std::mutex> lock(_m_batch_mutex);
+        if (generation != _m_batch_generation || _m_pending_batch.empty()) {
+            return;
+        }
+        batch.swap(_m_pending_batch);
+        _m_batch_generation++;
+    }
+    dispatch_batch(std::move(batch));
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param batch
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::dispatch_batch(std::vector<seriex_ctx*> batch) {
+    auto&& go_proc = std::bind(&BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_work, this, std::placeholders::_1);
+    auto* batch_task = WFTaskFactory::create_go_task(_m_server_uri, go_proc, std::move(batch));
+    batch_task->start();
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param req
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+bool BaseAiServerImpl<WORKER, MODEL_OUTPUT>::is_gzip_accepted(protocol::HttpRequest* req) const {
+    if (!_m_enable_response_compression) {
+        return false;
+    }
+    std::string accept_encoding;
+    protocol::HttpHeaderCursor cursor(req);
+    return cursor.find("Accept-Encoding", accept_encoding) && accepts_encoding(accept_encoding, "gzip");
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param series
+ * @param response
+ * @param body
+ * @param accept_gzip
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::append_http_body(
+    SeriesWork* series, protocol::HttpResponse* response, std::string body, bool accept_gzip) {
+    // body depends on Accept-Encoding whenever compression is on, caches must not serve it to other clients
+    if (_m_enable_response_compression) {
+        response->add_header_pair("Vary", "Accept-Encoding");
+    }
+    if (!accept_gzip || series == nullptr || body.size() < static_cast<size_t>(_m_response_compression_min_bytes)) {
+        response->append_output_body(body);
+        return;
+    }
+
+    // handler and compute threads are not held by compression, response is sent once the counter is done
+    std::call_once(_m_compression_pool_once, [this]() {
+        _m_compression_pool.reset(new StageThreadPool(static_cast<size_t>(_m_compression_threads)));
+    });
+    auto* compressed_counter = WFTaskFactory::create_counter_task(1, nullptr);
+    *series << compressed_counter;
+    auto compress_job = [this, response, compressed_counter, body = std::move(body)]() {
+        std::string compressed_body;
+        if (gzip_compress(body.data(), body.size(), _m_response_compression_level, compressed_body)
+            && compressed_body.size() < body.size()) {
+            response->add_header_pair("Content-Encoding", "gzip");
+            response->append_output_body(compressed_body);
+            _m_compressed_responses++;
+            _m_compression_saved_bytes += body.size() - compressed_body.size();
+        } else {
+            response->append_output_body(body);
+        }
+        compressed_counter->count();
+    };
+    _m_compression_pool->submit(std::move(compress_job));
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param status
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::fill_response(seriex_ctx* ctx, StatusCode status) {
+    if (ctx->rpc_response != nullptr) {
+        ctx->rpc_response->set_body(make_task_response(ctx, status));
+    } else {
+        append_http_body(ctx->series, ctx->response, make_task_response(ctx, status), ctx->accept_gzip);
+    }
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param ctx
+ * @param status
+ * @return
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+std::string BaseAiServerImpl<WORKER, MODEL_OUTPUT>::make_task_response(seriex_ctx* ctx, StatusCode status) {
+    std::string task_id = ctx->is_task_req_valid ? ctx->task_id : "";
+    auto encode_start_ts = Timestamp::now();
+    std::string response_body;
+    if (ctx->rpc_response != nullptr) {
+        response_body = make_rpc_response_body(task_id, status, ctx->model_output);
+    } else if (status == StatusCode::OK && !ctx->cached_response.empty()) {
+        response_body = fill_cached_req_id(ctx->cached_response, task_id);
+    } else {
+        response_body = make_response_body(task_id, status, ctx->model_output);
+        // cache response body without req id
+        if (status == StatusCode::OK && _m_enable_result_cache && ctx->has_cache_key) {
+            auto cached_response = strip_req_id(response_body, task_id);
+            if (!cached_response.empty()) {
+                _m_result_cache->put(ctx->cache_key, cached_response);
+            }
+        }
+    }
+    auto encode_finish_ts = Timestamp::now();
+    auto encode_time_consuming = (encode_finish_ts - encode_start_ts) * 1000;
+    auto total_time_consuming = (encode_finish_ts - ctx->serve_start_ts) * 1000;
+    _m_stage_latency[STAGE_RESPONSE_ENCODE].observe(encode_time_consuming);
+    _m_stage_latency[STAGE_TOTAL].observe(total_time_consuming);
+    if (_m_slow_request_sampler != nullptr && _m_slow_request_sampler->would_keep(total_time_consuming)) {
+        sample_slow_request(ctx, status, encode_time_consuming, total_time_consuming);
+    }
+
+    // update task count
+    _m_finished_jobs++;
+    _m_waiting_jobs--;
+
+    // failed requests are always logged, successful ones at sample rate
+    if (_m_access_logger != nullptr && (status != StatusCode::OK || _m_access_logger->sample())) {
+        access_log_entry entry;
+        entry.task_id = task_id;
+        entry.received_us = ctx->task_received_ts.micro_sec_since_epoch();
+        entry.finished_us = ctx->task_finished_ts.micro_sec_since_epoch();
+        entry.status = static_cast<int32_t>(status);
+        entry.elapse_ms = ctx->worker_run_time_consuming;
+        entry.wait_worker_ms = ctx->wait_worker_time_consuming;
+        entry.total_ms = total_time_consuming;
+        entry.batch_size = static_cast<uint32_t>(ctx->batch_size);
+        entry.received_jobs = _m_received_jobs;
+        entry.waiting_jobs = _m_waiting_jobs;
+        entry.finished_jobs = _m_finished_jobs;
+        entry.idle_workers = _m_working_queue.size_approx();
+        entry.worker_waiters = _m_working_queue.waiting_nums();
+        _m_access_logger->log(std::move(entry));
+    }
+    return response_body;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param task
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::serve_batch_request(WFHttpTask* task) {
+    auto* req = task->get_req();
+    auto* resp = task->get_resp();
+    auto serve_start_ts = Timestamp::now();
+
+    // body is read in place unless it was chunked
+    std::string chunked_body;
+    const void* body = nullptr;
+    size_t body_size = 0;
+    if (req->is_chunked()) {
+        chunked_body = protocol::HttpUtil::decode_chunked_body(req);
+        body = chunked_body.data();
+        body_size = chunked_body.size();
+    } else {
+        req->get_parsed_body(&body, &body_size);
+    }
+    std::vector<cls_request> task_reqs;
+    if (!parse_batch_task_request(static_cast<const char*>(body), body_size, task_reqs) || task_reqs.empty()) {
+        resp->append_output_body(make_admin_response_body(StatusCode::MODEL_EMPTY_INPUT_IMAGE, "invalid batch request"));
+        return;
+    }
+    if (task_reqs.size() > static_cast<size_t>(_m_max_batch_request_items)) {
+        resp->append_output_body(make_admin_response_body(
+            StatusCode::MODEL_EMPTY_INPUT_IMAGE,
+            "too many batch request items, max: " + std::to_string(_m_max_batch_request_items)));
+        return;
+    }
+    if (!admit_request(resp, task_reqs.size())) {
+        return;
+    }
+    int64_t header_deadline_ms = parse_deadline_header(req);
+    size_t tenant = find_tenant(req);
+    int peer_fd = get_peer_fd(task);
+
+    auto* batch_ctx = new batch_request_ctx;
+    batch_ctx->response = resp;
+    batch_ctx->accept_gzip = is_gzip_accepted(req);
+    batch_ctx->serve_start_ts = serve_start_ts;
+    batch_ctx->item_bodies.resize(task_reqs.size());
+    for (auto& task_req : task_reqs) {
+        if (header_deadline_ms >= 0) {
+            task_req.deadline_ms = header_deadline_ms;
+        }
+        std::unique_ptr<seriex_ctx> ctx(new seriex_ctx);
+        ctx->serve_start_ts = serve_start_ts;
+        ctx->tenant = tenant;
+        ctx->peer_fd = peer_fd;
+        ctx->deadline = make_deadline(task_req);
+        ctx->task_id = task_req.task_id;
+        ctx->is_task_req_valid = task_req.is_valid;
+        ctx->task_received_ts = serve_start_ts;
+        ctx->request = std::move(task_req);
+        batch_ctx->items.push_back(std::move(ctx));
+    }
+    auto parse_time_consuming = (Timestamp::now() - serve_start_ts) * 1000;
+    _m_stage_latency[STAGE_REQUEST_PARSE].observe(parse_time_consuming);
+    for (auto& ctx : batch_ctx->items) {
+        ctx->parse_time_consuming = parse_time_consuming;
+    }
+    _m_waiting_jobs += batch_ctx->items.size();
+    _m_received_jobs += batch_ctx->items.size();
+
+    // items run in parallel, response is merged once all of them finished
+    auto* series = series_of(task);
+    series->set_context(batch_ctx);
+    series->set_callback([](const SeriesWork* series) {
+        delete (batch_request_ctx*)series->get_context();
+    });
+    auto* pwork = Workflow::create_parallel_work([this](const ParallelWork* pwork) {
+        auto* series = series_of(pwork);
+        auto* batch_ctx = (batch_request_ctx*)series->get_context();
+        append_http_body(
+            series, batch_ctx->response, make_batch_response_body(batch_ctx->item_bodies), batch_ctx->accept_gzip);
+    });
+    for (size_t i = 0; i < batch_ctx->items.size(); ++i) {
+        auto* item_task = WFTaskFactory::create_go_task(
+            _m_server_uri + "/batch", &BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_request_item, this, batch_ctx, i);
+        pwork->add_series(Workflow::create_series_work(item_task, nullptr));
+    }
+    *series << pwork;
+}
+
+/***
+ *
+ * @tparam WORKER
+ * @tparam MODEL_OUTPUT
+ * @param batch_ctx
+ * @param index
+ */
+template<typename WORKER, typename MODEL_OUTPUT>
+void BaseAiServerImpl<WORKER, MODEL_OUTPUT>::do_batch_request_item(
+    BaseAiServerImpl::batch_request_ctx* batch_ctx, size_t index) {
+    auto* ctx = batch_ctx->items[index].get();
+    auto task_receive_ts = Timestamp::now();
+    models::io_define::common_io::mat_input model_input;
+    StatusCode status = StatusCode::MODEL_EMPTY_INPUT_IMAGE;
+
+    if (ctx->is_task_req_valid && is_expired(ctx)) {
+        status = StatusCode::MODEL_RUN_DEADLINE_EXCEEDED;
+    } else if (ctx->is_task_req_valid && is_cancelled(ctx)) {
+        status = StatusCode::MODEL_RUN_CANCELLED;
+    } else if (ctx->is_task_req_valid && !prepare_model_input(ctx->request, ctx, model_input)) {
+        // invalid image or result cache hit
+        status = ctx->model_run_status;
+    } else if (ctx->is_task_req_valid) {
+        std::string().swap(ctx->request.image_content);
+        status = infer_on_worker(model_input, ctx);
+    }
 
-    // output log info
-    LOG(INFO) << "task id: " << task_id
-              << " received at: " << ctx->task_received_ts
-              << " finished at: " << ctx->task_finished_ts
-              << " elapse: " << ctx->worker_run_time_consuming << " ms"
-              << " find work elapse: " << ctx->find_worker_time_consuming << " ms"
-              << " received jobs: " << _m_received_jobs
-              << " waiting jobs: " << _m_waiting_jobs
-              << " finished jobs: " << _m_finished_jobs
-              << " worker queue size: " << _m_working_queue.size_approx();
-    // WFTaskFactory::count_by_name("release_ctx");
+    finish_model_run(ctx, status, task_receive_ts);
+    batch_ctx->item_bodies[index] = make_task_response(ctx, status);
+    // model output is not needed any more once encoded
+    ctx->model_output = MODEL_OUTPUT();
 }
 }
 }
@@ -0,0 +1,371 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: binary_rpc_message.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "binary_rpc_message.h"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace jinq {
+namespace server {
+
+namespace {
+
+const char RPC_MAGIC[4] = {'M', 'R', 'P', 'C'};
+
+/***
+ *
+ * @param value
+ * @param body
+ */
+void append_u32(uint32_t value, std::string& body) {
+    char bytes[4] = {
+        static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF),
+        static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF)
+    };
+    body.append(bytes, 4);
+}
+
+/***
+ *
+ * @param value
+ * @param body
+ */
+void append_u16(uint16_t value, std::string& body) {
+    char bytes[2] = {static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF)};
+    body.append(bytes, 2);
+}
+
+/***
+ *
+ * @param value
+ * @param body
+ */
+void append_i32(int32_t value, std::string& body) {
+    append_u32(static_cast<uint32_t>(value), body);
+}
+
+/***
+ *
+ * @param value
+ * @param body
+ */
+void append_f32(float value, std::string& body) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_u32(bits, body);
+}
+
+/***
+ *
+ * @param rect
+ * @param body
+ */
+void append_rect(const cv::Rect2f& rect, std::string& body) {
+    append_f32(rect.x, body);
+    append_f32(rect.y, body);
+    append_f32(rect.width, body);
+    append_f32(rect.height, body);
+}
+
+/***
+ *
+ * @param points
+ * @param body
+ */
+void append_points(const std::vector<cv::Point2f>& points, std::string& body) {
+    append_u32(static_cast<uint32_t>(points.size()), body);
+    for (const auto& pt : points) {
+        append_f32(pt.x, body);
+        append_f32(pt.y, body);
+    }
+}
+
+/***
+ *
+ * @param values
+ * @param body
+ */
+void append_floats(const std::vector<float>& values, std::string& body) {
+    append_u32(static_cast<uint32_t>(values.size()), body);
+    for (auto value : values) {
+        append_f32(value, body);
+    }
+}
+
+/***
+ *
+ * @param data
+ * @return
+ */
+uint32_t read_u32(const char* data) {
+    auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8)
+           | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+/***
+ *
+ * @param data
+ * @return
+ */
+uint16_t read_u16(const char* data) {
+    auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+/***
+ * read uint16 size prefixed string
+ * @param body
+ * @param offset
+ * @param value
+ * @return
+ */
+bool read_string(const std::string& body, size_t& offset, std::string& value) {
+    if (body.size() < offset + 2) {
+        return false;
+    }
+    size_t size = read_u16(body.data() + offset);
+    offset += 2;
+    if (body.size() < offset + size) {
+        return false;
+    }
+    value.assign(body.data() + offset, size);
+    offset += size;
+    return true;
+}
+}
+
+/***
+ *
+ * @param vectors
+ * @param max
+ * @return
+ */
+int BinaryRpcMessage::encode(struct iovec vectors[], int max) {
+    if (max < 2) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    std::memcpy(_m_head, RPC_MAGIC, sizeof(RPC_MAGIC));
+    std::string body_size;
+    append_u32(static_cast<uint32_t>(_m_body.size()), body_size);
+    std::memcpy(_m_head + sizeof(RPC_MAGIC), body_size.data(), 4);
+
+    vectors[0].iov_base = _m_head;
+    vectors[0].iov_len = HEAD_SIZE;
+    if (_m_body.empty()) {
+        return 1;
+    }
+    vectors[1].iov_base = const_cast<char*>(_m_body.data());
+    vectors[1].iov_len = _m_body.size();
+    return 2;
+}
+
+/***
+ *
+ * @param buf
+ * @param size
+ * @return
+ */
+int BinaryRpcMessage::append(const void* buf, size_t size) {
+    auto* data = static_cast<const char*>(buf);
+    if (_m_head_received < HEAD_SIZE) {
+        size_t head_size = std::min(size, HEAD_SIZE - _m_head_received);
+        std::memcpy(_m_head + _m_head_received, data, head_size);
+        _m_head_received += head_size;
+        data += head_size;
+        size -= head_size;
+        if (_m_head_received < HEAD_SIZE) {
+            return 0;
+        }
+        if (std::memcmp(_m_head, RPC_MAGIC, sizeof(RPC_MAGIC)) != 0) {
+            errno = EBADMSG;
+            return -1;
+        }
+        _m_body_size = read_u32(_m_head + sizeof(RPC_MAGIC));
+        if (_m_body_size > this->size_limit) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        _m_body.reserve(_m_body_size);
+    }
+
+    // pipelined bytes of next frame are not supported
+    if (_m_body.size() + size > _m_body_size) {
+        errno = EBADMSG;
+        return -1;
+    }
+    _m_body.append(data, size);
+    return _m_body.size() == _m_body_size ? 1 : 0;
+}
+
+namespace binary_rpc {
+
+using models::io_define::object_detection::std_object_detection_output;
+using models::io_define::object_detection::std_face_detection_output;
+using models::io_define::ocr::std_text_regions_output;
+using models::io_define::classification::std_classification_output;
+using models::io_define::feature_point::std_feature_point_output;
+using models::io_define::scene_segmentation::std_scene_segmentation_output;
+using models::io_define::matting::std_matting_output;
+using models::io_define::enhancement::std_enhancement_output;
+
+/***
+ *
+ * @param body
+ * @param req
+ * @return
+ */
+bool parse_request_body(const std::string& body, rpc_request& req) {
+    size_t offset = 0;
+    if (!read_string(body, offset, req.server_uri) || !read_string(body, offset, req.task_id)) {
+        return false;
+    }
+    if (body.size() < offset + 4) {
+        return false;
+    }
+    req.deadline_ms = static_cast<int32_t>(read_u32(body.data() + offset));
+    offset += 4;
+    req.image_data = body.data() + offset;
+    req.image_data_size = body.size() - offset;
+    return true;
+}
+
+/***
+ *
+ * @param code
+ * @param task_id
+ * @param body
+ */
+void pack_response_head(int32_t code, const std::string& task_id, std::string& body) {
+    append_i32(code, body);
+    auto task_id_size = std::min<size_t>(task_id.size(), UINT16_MAX);
+    append_u16(static_cast<uint16_t>(task_id_size), body);
+    body.append(task_id.data(), task_id_size);
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_object_detection_output& output, std::string& body) {
+    body.reserve(body.size() + 4 + output.size() * 24);
+    append_u32(static_cast<uint32_t>(output.size()), body);
+    for (const auto& box : output) {
+        append_rect(box.bbox, body);
+        append_f32(box.score, body);
+        append_i32(box.class_id, body);
+    }
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_face_detection_output& output, std::string& body) {
+    append_u32(static_cast<uint32_t>(output.size()), body);
+    for (const auto& box : output) {
+        append_rect(box.bbox, body);
+        append_f32(box.score, body);
+        append_i32(box.class_id, body);
+        append_points(box.landmarks, body);
+    }
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_text_regions_output& output, std::string& body) {
+    append_u32(static_cast<uint32_t>(output.size()), body);
+    for (const auto& region : output) {
+        append_rect(region.bbox, body);
+        append_f32(region.score, body);
+        append_points(region.polygon, body);
+    }
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_classification_output& output, std::string& body) {
+    append_i32(output.class_id, body);
+    append_floats(output.scores, body);
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_feature_point_output& output, std::string& body) {
+    append_u32(static_cast<uint32_t>(output.size()), body);
+    for (const auto& point : output) {
+        append_f32(point.location.x, body);
+        append_f32(point.location.y, body);
+        append_f32(point.score, body);
+        append_floats(point.descriptor, body);
+    }
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_scene_segmentation_output& output, std::string& body) {
+    pack_mat(output.segmentation_result, body);
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_matting_output& output, std::string& body) {
+    pack_mat(output.matting_result, body);
+}
+
+/***
+ *
+ * @param output
+ * @param body
+ */
+void pack_model_output(const std_enhancement_output& output, std::string& body) {
+    pack_mat(output.enhancement_result, body);
+}
+
+/***
+ *
+ * @param mat
+ * @param body
+ */
+void pack_mat(const cv::Mat& mat, std::string& body) {
+    cv::Mat continuous_mat = mat.isContinuous() ? mat : mat.clone();
+    auto data_size = continuous_mat.total() * continuous_mat.elemSize();
+    body.reserve(body.size() + 16 + data_size);
+    append_i32(continuous_mat.rows, body);
+    append_i32(continuous_mat.cols, body);
+    append_i32(continuous_mat.type(), body);
+    append_u32(static_cast<uint32_t>(data_size), body);
+    if (data_size > 0) {
+        body.append(reinterpret_cast<const char*>(continuous_mat.data), data_size);
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,198 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: binary_rpc_message.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_BINARY_RPC_MESSAGE_H
+#define MM_AI_SERVER_BINARY_RPC_MESSAGE_H
+
+#include <cstdint>
+#include <string>
+
+#include "workflow/ProtocolMessage.h"
+#include "workflow/WFServer.h"
+#include "workflow/WFTask.h"
+
+#include "models/model_io_define.h"
+
+namespace jinq {
+namespace server {
+
+/***
+ * Length prefixed binary message served on rpc port. Every frame is a 4 bytes magic "MRPC"
+ * followed by a little endian uint32 body size and the body. One request per connection is
+ * in flight at a time, client sends next request after the response of last one arrives
+ */
+class BinaryRpcMessage : public protocol::ProtocolMessage {
+public:
+    static constexpr size_t HEAD_SIZE = 8;
+
+    /***
+     * constructor
+     */
+    BinaryRpcMessage() = default;
+
+    /***
+     *
+     */
+    ~BinaryRpcMessage() override = default;
+
+    /***
+     * move constructor
+     * @param msg
+     */
+    BinaryRpcMessage(BinaryRpcMessage&& msg) = default;
+
+    /***
+     *
+     * @param msg
+     * @return
+     */
+    BinaryRpcMessage& operator=(BinaryRpcMessage&& msg) = default;
+
+    /***
+     *
+     * @param body
+     */
+    void set_body(std::string body) {
+        _m_body = std::move(body);
+    }
+
+    /***
+     *
+     * @return
+     */
+    const std::string& get_body() const {
+        return _m_body;
+    }
+
+protected:
+    /***
+     *
+     * @param vectors
+     * @param max
+     * @return
+     */
+    int encode(struct iovec vectors[], int max) override;
+
+    /***
+     *
+     * @param buf
+     * @param size
+     * @return 1 once the whole frame is received, 0 if more data is needed, -1 on bad frame
+     */
+    int append(const void* buf, size_t size) override;
+
+private:
+    char _m_head[HEAD_SIZE] = {0};
+    size_t _m_head_received = 0;
+    size_t _m_body_size = 0;
+    std::string _m_body;
+};
+
+using BinaryRpcRequest = BinaryRpcMessage;
+using BinaryRpcResponse = BinaryRpcMessage;
+using WFBinaryRpcTask = WFNetworkTask<BinaryRpcRequest, BinaryRpcResponse>;
+using WFBinaryRpcServer = WFServer<BinaryRpcRequest, BinaryRpcResponse>;
+
+namespace binary_rpc {
+
+/***
+ * request body: uint16 uri size | server uri | uint16 req id size | req id | int32 deadline ms | image bytes.
+ * image bytes point into the request body
+ */
+struct rpc_request {
+    std::string server_uri;
+    std::string task_id;
+    int32_t deadline_ms = -1;
+    const char* image_data = nullptr;
+    size_t image_data_size = 0;
+};
+
+/***
+ *
+ * @param body
+ * @param req
+ * @return false if body is truncated
+ */
+bool parse_request_body(const std::string& body, rpc_request& req);
+
+/***
+ * response body starts with int32 status code | uint16 req id size | req id, packed model output
+ * follows if status code is 0
+ * @param code
+ * @param task_id
+ * @param body
+ */
+void pack_response_head(int32_t code, const std::string& task_id, std::string& body);
+
+/***
+ * uint32 count | count * (float x, y, w, h, score | int32 class id)
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::object_detection::std_object_detection_output& output, std::string& body);
+
+/***
+ * uint32 count | count * (float x, y, w, h, score | int32 class id | uint32 n | n * float x, y)
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::object_detection::std_face_detection_output& output, std::string& body);
+
+/***
+ * uint32 count | count * (float x, y, w, h, score | uint32 n | n * float x, y)
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::ocr::std_text_regions_output& output, std::string& body);
+
+/***
+ * int32 class id | uint32 n | n * float score
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::classification::std_classification_output& output, std::string& body);
+
+/***
+ * uint32 count | count * (float x, y, score | uint32 n | n * float descriptor)
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::feature_point::std_feature_point_output& output, std::string& body);
+
+/***
+ * mask in packed mat layout, see pack_mat
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::scene_segmentation::std_scene_segmentation_output& output, std::string& body);
+
+/***
+ * matte in packed mat layout, see pack_mat
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::matting::std_matting_output& output, std::string& body);
+
+/***
+ * enhanced image in packed mat layout, see pack_mat
+ * @param output
+ * @param body
+ */
+void pack_model_output(const models::io_define::enhancement::std_enhancement_output& output, std::string& body);
+
+/***
+ * int32 rows | int32 cols | int32 opencv mat type | uint32 data size | row major pixel data
+ * @param mat
+ * @param body
+ */
+void pack_mat(const cv::Mat& mat, std::string& body);
+
+}
+}
+}
+
+#endif //MM_AI_SERVER_BINARY_RPC_MESSAGE_H
@@ -31,9 +31,9 @@ using jinq::server::BaseAiServerImpl;
 namespace classification {
 
 using jinq::factory::classification::create_mobilenetv2_classifier;
-using jinq::models::io_define::common_io::base64_input;
+using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::classification::std_classification_output;
-using MoblieNetv2NetPtr = decltype(create_mobilenetv2_classifier<base64_input, std_classification_output>(""));
+using MoblieNetv2NetPtr = decltype(create_mobilenetv2_classifier<mat_input, std_classification_output>(""));
 
 /************ Impl Declaration ************/
 
@@ -47,6 +47,14 @@ public:
     StatusCode init(const decltype(toml::parse(""))& config) override;
 
 protected:
+    /***
+     *
+     * @param config
+     * @param workers
+     * @return
+     */
+    StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<MoblieNetv2NetPtr>& workers) override;
+
     /***
      *
      * @param task_id
@@ -70,29 +78,11 @@ protected:
 StatusCode MobileNetv2Server::Impl::init(const decltype(toml::parse("")) &config) {
     // init working queue
     auto server_section = config.at("MOBILENETV2_CLASSIFICATION_SERVER");
-    auto worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
-    auto model_section = config.at("MOBILENETV2");
-    auto model_cfg_path = model_section.at("model_config_file_path").as_string();
-
-    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
-        LOG(FATAL) << "mobilenetv2 model config file not exist: " << model_cfg_path;
+    if (init_working_queue(config) != StatusCode::OK) {
         _m_successfully_initialized = false;
         return StatusCode::SERVER_INIT_FAILED;
     }
 
-    auto model_cfg = toml::parse(model_cfg_path);
-    for (int index = 0; index < worker_nums; ++index) {
-        auto worker = create_mobilenetv2_classifier<base64_input, std_classification_output>(
-                          "worker_" + std::to_string(index + 1));
-        if (!worker->is_successfully_initialized()) {
-            if (worker->init(model_cfg) != StatusCode::OK) {
-                _m_successfully_initialized = false;
-                return StatusCode::SERVER_INIT_FAILED;
-            }
-        }
-        _m_working_queue.enqueue(std::move(worker));
-    }
-
     // init worker run timeout
     if (!server_section.contains("model_run_timeout")) {
         _m_model_run_timeout = 500; // ms
@@ -115,11 +105,48 @@ StatusCode MobileNetv2Server::Impl::init(const decltype(toml::parse("")) &config
     compute_threads = static_cast<int>(server_section.at("compute_threads").as_integer());
     handler_threads = static_cast<int>(server_section.at("handler_threads").as_integer());
 
+    // init server options
+    if (init_server_options(server_section) != StatusCode::OK) {
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
     _m_successfully_initialized = true;
     LOG(INFO) << "Mobilenetv2 classification server init successfully";
     return StatusCode::OK;
 }
 
+/***
+ *
+ * @param config
+ * @param workers
+ * @return
+ */
+StatusCode MobileNetv2Server::Impl::create_workers(const decltype(toml::parse("")) &config, std::vector<MoblieNetv2NetPtr>& workers) {
+    auto worker_nums = static_cast<int>(config.at("MOBILENETV2_CLASSIFICATION_SERVER").at("worker_nums").as_integer());
+    auto model_section = config.at("MOBILENETV2");
+    auto model_cfg_path = model_section.at("model_config_file_path").as_string();
+
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "mobilenetv2 model config file not exist: " << model_cfg_path;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    auto model_cfg = toml::parse(model_cfg_path);
+    for (int index = 0; index < worker_nums; ++index) {
+        auto worker = create_mobilenetv2_classifier<mat_input, std_classification_output>(
+                          "worker_" + std::to_string(index + 1));
+        if (!worker->is_successfully_initialized()) {
+            if (worker->init(model_cfg) != StatusCode::OK) {
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    return StatusCode::OK;
+}
+
 /***
  *
  * @param task_id
@@ -203,7 +230,7 @@ jinq::common::StatusCode MobileNetv2Server::init(const decltype(toml::parse(""))
 
     auto&& proc = std::bind(
                       &MobileNetv2Server::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
-    _m_server = std::make_unique<WFHttpServer>(proc);
+    _m_server = std::make_unique<PeerAwareHttpServer>(proc);
 
     return StatusCode::OK;
 }
@@ -216,6 +243,14 @@ void MobileNetv2Server::serve_process(WFHttpTask* task) {
     return _m_impl->serve_process(task);
 }
 
+/***
+ *
+ * @param task
+ */
+void MobileNetv2Server::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
 /***
  *
  * @return
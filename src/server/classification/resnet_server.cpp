@@ -31,9 +31,9 @@ using jinq::server::BaseAiServerImpl;
 namespace classification {
 
 using jinq::factory::classification::create_resnet_classifier;
-using jinq::models::io_define::common_io::base64_input;
+using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::classification::std_classification_output;
-using ResNetPtr = decltype(create_resnet_classifier<base64_input, std_classification_output>(""));
+using ResNetPtr = decltype(create_resnet_classifier<mat_input, std_classification_output>(""));
 
 /************ Impl Declaration ************/
 
@@ -47,6 +47,14 @@ public:
     StatusCode init(const decltype(toml::parse(""))& config) override;
 
 protected:
+    /***
+     *
+     * @param config
+     * @param workers
+     * @return
+     */
+    StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<ResNetPtr>& workers) override;
+
     /***
      *
      * @param task_id
@@ -70,30 +78,11 @@ protected:
 StatusCode ResNetServer::Impl::init(const decltype(toml::parse("")) &config) {
     // init working queue
     auto server_section = config.at("RESNET_CLASSIFICATION_SERVER");
-    auto worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
-    auto model_section = config.at("RESNET");
-    auto model_cfg_path = model_section.at("model_config_file_path").as_string();
-
-    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
-        LOG(FATAL) << "resnet model config file not exist: " << model_cfg_path;
+    if (init_working_queue(config) != StatusCode::OK) {
         _m_successfully_initialized = false;
         return StatusCode::SERVER_INIT_FAILED;
     }
 
-    auto model_cfg = toml::parse(model_cfg_path);
-    for (int index = 0; index < worker_nums; ++index) {
-        auto worker = create_resnet_classifier<base64_input, std_classification_output>(
-                          "worker_" + std::to_string(index + 1));
-        if (!worker->is_successfully_initialized()) {
-            if (worker->init(model_cfg) != StatusCode::OK) {
-                _m_successfully_initialized = false;
-                return StatusCode::SERVER_INIT_FAILED;
-            }
-        }
-
-        _m_working_queue.enqueue(std::move(worker));
-    }
-
     // init worker run timeout
     if (!server_section.contains("model_run_timeout")) {
         _m_model_run_timeout = 500; // ms
@@ -116,11 +105,49 @@ StatusCode ResNetServer::Impl::init(const decltype(toml::parse("")) &config) {
     compute_threads = static_cast<int>(server_section.at("compute_threads").as_integer());
     handler_threads = static_cast<int>(server_section.at("handler_threads").as_integer());
 
+    // init server options
+    if (init_server_options(server_section) != StatusCode::OK) {
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
     _m_successfully_initialized = true;
     LOG(INFO) << "Resnet classification server init successfully";
     return StatusCode::OK;
 }
 
+/***
+ *
+ * @param config
+ * @param workers
+ * @return
+ */
+StatusCode ResNetServer::Impl::create_workers(const decltype(toml::parse("")) &config, std::vector<ResNetPtr>& workers) {
+    auto worker_nums = static_cast<int>(config.at("RESNET_CLASSIFICATION_SERVER").at("worker_nums").as_integer());
+    auto model_section = config.at("RESNET");
+    auto model_cfg_path = model_section.at("model_config_file_path").as_string();
+
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "resnet model config file not exist: " << model_cfg_path;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    auto model_cfg = toml::parse(model_cfg_path);
+    for (int index = 0; index < worker_nums; ++index) {
+        auto worker = create_resnet_classifier<mat_input, std_classification_output>(
+                          "worker_" + std::to_string(index + 1));
+        if (!worker->is_successfully_initialized()) {
+            if (worker->init(model_cfg) != StatusCode::OK) {
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+        }
+
+        workers.push_back(std::move(worker));
+    }
+
+    return StatusCode::OK;
+}
+
 /***
  *
  * @param task_id
@@ -204,7 +231,7 @@ jinq::common::StatusCode ResNetServer::init(const decltype(toml::parse("")) &con
 
     auto&& proc = std::bind(
                       &ResNetServer::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
-    _m_server = std::make_unique<WFHttpServer>(proc);
+    _m_server = std::make_unique<PeerAwareHttpServer>(proc);
 
     return StatusCode::OK;
 }
@@ -217,6 +244,14 @@ void ResNetServer::serve_process(WFHttpTask* task) {
     return _m_impl->serve_process(task);
 }
 
+/***
+ *
+ * @param task
+ */
+void ResNetServer::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
 /***
  *
  * @return
@@ -55,6 +55,12 @@ public:
      */
     void serve_process(WFHttpTask* task) override;
 
+    /***
+     *
+     * @param task
+     */
+    void serve_rpc_process(WFBinaryRpcTask* task) override;
+
     /***
      *
      * @return
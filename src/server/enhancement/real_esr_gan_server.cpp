@@ -33,9 +33,9 @@ using jinq::server::BaseAiServerImpl;
 namespace enhancement {
 
 using jinq::factory::enhancement::create_realesrgan_enhancementor;
-using jinq::models::io_define::common_io::base64_input;
+using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::enhancement::std_enhancement_output;
-using RealEsrGanPtr = decltype(create_realesrgan_enhancementor<base64_input, std_enhancement_output>(""));
+using RealEsrGanPtr = decltype(create_realesrgan_enhancementor<mat_input, std_enhancement_output>(""));
 
 /************ Impl Declaration ************/
 
@@ -49,6 +49,14 @@ public:
     StatusCode init(const decltype(toml::parse(""))& config) override;
 
 protected:
+    /***
+     *
+     * @param config
+     * @param workers
+     * @return
+     */
+    StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<RealEsrGanPtr>& workers) override;
+
     /***
      *
      * @param task_id
@@ -72,31 +80,11 @@ protected:
 StatusCode RealEsrGanServer::Impl::init(const decltype(toml::parse("")) &config) {
     // init working queue
     auto server_section = config.at("REAL_ESRGAN_SERVER");
-    auto worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
-    auto model_cfg_path = config.at("REAL_ESRGAN_SERVER").at("model_config_file_path").as_string();
-
-    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
-        LOG(FATAL) << "real esr-gan model config file not exist: " << model_cfg_path;
+    if (init_working_queue(config) != StatusCode::OK) {
         _m_successfully_initialized = false;
         return StatusCode::SERVER_INIT_FAILED;
     }
 
-    auto model_cfg = toml::parse(model_cfg_path);
-
-    for (int index = 0; index < worker_nums; ++index) {
-        auto worker = create_realesrgan_enhancementor<base64_input, std_enhancement_output>(
-                "worker_" + std::to_string(index + 1));
-
-        if (!worker->is_successfully_initialized()) {
-            if (worker->init(model_cfg) != StatusCode::OK) {
-                _m_successfully_initialized = false;
-                return StatusCode::SERVER_INIT_FAILED;
-            }
-        }
-
-        _m_working_queue.enqueue(std::move(worker));
-    }
-
     // init worker run timeout
     if (!server_section.contains("model_run_timeout")) {
         _m_model_run_timeout = 500; // ms
@@ -119,11 +107,50 @@ StatusCode RealEsrGanServer::Impl::init(const decltype(toml::parse("")) &config)
     compute_threads = static_cast<int>(server_section.at("compute_threads").as_integer());
     handler_threads = static_cast<int>(server_section.at("handler_threads").as_integer());
 
+    // init server options
+    if (init_server_options(server_section) != StatusCode::OK) {
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
     _m_successfully_initialized = true;
     LOG(INFO) << "real esr-gan server init successfully";
     return StatusCode::OK;
 }
 
+/***
+ *
+ * @param config
+ * @param workers
+ * @return
+ */
+StatusCode RealEsrGanServer::Impl::create_workers(const decltype(toml::parse("")) &config, std::vector<RealEsrGanPtr>& workers) {
+    auto worker_nums = static_cast<int>(config.at("REAL_ESRGAN_SERVER").at("worker_nums").as_integer());
+    auto model_cfg_path = config.at("REAL_ESRGAN_SERVER").at("model_config_file_path").as_string();
+
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "real esr-gan model config file not exist: " << model_cfg_path;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    auto model_cfg = toml::parse(model_cfg_path);
+
+    for (int index = 0; index < worker_nums; ++index) {
+        auto worker = create_realesrgan_enhancementor<mat_input, std_enhancement_output>(
+                "worker_" + std::to_string(index + 1));
+
+        if (!worker->is_successfully_initialized()) {
+            if (worker->init(model_cfg) != StatusCode::OK) {
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+        }
+
+        workers.push_back(std::move(worker));
+    }
+
+    return StatusCode::OK;
+}
+
 /***
  *
  * @param task_id
@@ -206,7 +233,7 @@ jinq::common::StatusCode RealEsrGanServer::init(const decltype(toml::parse(""))
 
     auto&& proc = std::bind(
                       &RealEsrGanServer::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
-    _m_server = std::make_unique<WFHttpServer>(proc);
+    _m_server = std::make_unique<PeerAwareHttpServer>(proc);
 
     return StatusCode::OK;
 }
@@ -219,6 +246,14 @@ void RealEsrGanServer::serve_process(WFHttpTask* task) {
     return _m_impl->serve_process(task);
 }
 
+/***
+ *
+ * @param task
+ */
+void RealEsrGanServer::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
 /***
  *
  * @return
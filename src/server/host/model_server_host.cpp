@@ -0,0 +1,335 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: model_server_host.cpp
+* Date: 26-10-16
+************************************************/
+
+#include "model_server_host.h"
+
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "toml/toml.hpp"
+#include "workflow/WFFacilities.h"
+#include "workflow/WFHttpServer.h"
+
+namespace jinq {
+namespace server {
+
+using jinq::common::StatusCode;
+
+namespace host {
+
+/************ Impl Declaration ************/
+
+class ModelServerHost::Impl {
+public:
+    /***
+     *
+     * @param server_section_name
+     * @param server_cfg
+     * @param server
+     * @return
+     */
+    StatusCode add_server(
+        const std::string& server_section_name,
+        const decltype(toml::parse(""))& server_cfg,
+        std::unique_ptr<BaseAiServer> server);
+
+    /***
+     *
+     * @param cfg
+     * @return
+     */
+    StatusCode init(const decltype(toml::parse(""))& cfg);
+
+    /***
+     *
+     * @param task
+     */
+    void serve_process(WFHttpTask* task);
+
+    /***
+     *
+     * @param task
+     */
+    void serve_rpc_process(WFBinaryRpcTask* task);
+
+    /***
+     *
+     * @return
+     */
+    bool is_successfully_initialized() const {
+        return _m_successfully_initialized;
+    }
+
+public:
+    int max_connection_nums = 200;
+    int peer_resp_timeout = 15 * 1000;
+    int compute_threads = -1;
+    int handler_threads = 50;
+
+private:
+    struct hosted_server {
+        std::string section_name;
+        std::string server_url;
+        int worker_nums = 0;
+        std::unique_ptr<BaseAiServer> server;
+    };
+
+    // init flag
+    bool _m_successfully_initialized = false;
+    // hosted model servers
+    std::vector<hosted_server> _m_servers;
+    // server url -> model server
+    std::unordered_map<std::string, BaseAiServer*> _m_routes;
+};
+
+/************ Impl Implementation ************/
+
+/***
+ *
+ * @param server_section_name
+ * @param server_cfg
+ * @param server
+ * @return
+ */
+StatusCode ModelServerHost::Impl::add_server(
+    const std::string& server_section_name,
+    const decltype(toml::parse(""))& server_cfg,
+    std::unique_ptr<BaseAiServer> server) {
+    if (server == nullptr) {
+        LOG(ERROR) << "empty model server for section: " << server_section_name;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    if (!server_cfg.contains(server_section_name)) {
+        LOG(ERROR) << "missing server section: " << server_section_name;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    const auto& server_section = server_cfg.at(server_section_name);
+    if (!server_section.contains("server_url")) {
+        LOG(ERROR) << "missing server uri field in section: " << server_section_name;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    std::string server_url = server_section.at("server_url").as_string();
+    if (_m_routes.find(server_url) != _m_routes.end()) {
+        LOG(ERROR) << "duplicated server uri: " << server_url << " of section: " << server_section_name;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    // model server's own http server and thread settings are overridden by host
+    auto status = server->init(server_cfg);
+    if (status != StatusCode::OK || !server->is_successfully_initialized()) {
+        LOG(ERROR) << "init model server of section: " << server_section_name << " failed";
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    hosted_server hosted;
+    hosted.section_name = server_section_name;
+    hosted.server_url = server_url;
+    hosted.worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
+    hosted.server = std::move(server);
+    _m_routes[server_url] = hosted.server.get();
+    _m_routes[server_url + "/batch"] = hosted.server.get();
+    _m_servers.push_back(std::move(hosted));
+    LOG(INFO) << "host model server: " << server_section_name << " at: " << server_url;
+
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @param config
+ * @return
+ */
+StatusCode ModelServerHost::Impl::init(const decltype(toml::parse("")) &config) {
+    if (!config.contains("MODEL_SERVER_HOST")) {
+        LOG(ERROR) << "missing MODEL_SERVER_HOST section";
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    if (_m_servers.empty()) {
+        LOG(ERROR) << "no model server was hosted";
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+    const auto& host_section = config.at("MODEL_SERVER_HOST");
+
+    // init shared server params
+    max_connection_nums = static_cast<int>(host_section.at("max_connections").as_integer());
+    peer_resp_timeout = static_cast<int>(host_section.at("peer_resp_timeout").as_integer()) * 1000;
+    compute_threads = static_cast<int>(host_section.at("compute_threads").as_integer());
+    handler_threads = static_cast<int>(host_section.at("handler_threads").as_integer());
+
+    // every go task holds one compute thread while it waits for or runs on a model worker,
+    // budget at least one thread per worker so that one model's backlog never starves the others
+    int total_worker_nums = 0;
+    for (const auto& hosted : _m_servers) {
+        total_worker_nums += hosted.worker_nums;
+    }
+    int budget_compute_threads = compute_threads > 0 ?
+                                 compute_threads : static_cast<int>(std::thread::hardware_concurrency());
+    if (budget_compute_threads < total_worker_nums + 1) {
+        LOG(WARNING) << "compute threads: " << budget_compute_threads << " is less than total worker nums: "
+                     << total_worker_nums << " of all hosted models, raise it to: " << total_worker_nums + 1;
+        budget_compute_threads = total_worker_nums + 1;
+    }
+    compute_threads = budget_compute_threads;
+
+    _m_successfully_initialized = true;
+    LOG(INFO) << "Model server host init successfully, hosted models: " << _m_servers.size()
+              << ", compute threads: " << compute_threads << ", handler threads: " << handler_threads
+              << ", max connections: " << max_connection_nums;
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @param task
+ */
+void ModelServerHost::Impl::serve_process(WFHttpTask* task) {
+    std::string request_uri = task->get_req()->get_request_uri();
+
+    // welcome message
+    if (request_uri == "/welcome") {
+        task->get_resp()->append_output_body("<html>Welcome to jinq ai server</html>");
+        return;
+    }
+    // hello world message
+    else if (request_uri == "/hello_world") {
+        task->get_resp()->append_output_body("<html>Hello World !!!</html>");
+        return;
+    }
+
+    // model service
+    auto route = _m_routes.find(request_uri);
+    if (route != _m_routes.end()) {
+        route->second->serve_process(task);
+        return;
+    }
+
+    // model metrics and admin endpoints served at ${server_url}/metrics and ${server_url}/admin/reload
+    for (const std::string suffix : {"/metrics", "/admin/reload"}) {
+        if (request_uri.size() <= suffix.size()
+                || request_uri.compare(request_uri.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        route = _m_routes.find(request_uri.substr(0, request_uri.size() - suffix.size()));
+        if (route != _m_routes.end()) {
+            task->get_req()->set_request_uri(suffix);
+            route->second->serve_process(task);
+            return;
+        }
+    }
+
+    // not found valid url
+    task->get_resp()->append_output_body("<html>404 Not Found</html>");
+}
+
+/***
+ *
+ * @param task
+ */
+void ModelServerHost::Impl::serve_rpc_process(WFBinaryRpcTask* task) {
+    // route by server uri carried in request body
+    binary_rpc::rpc_request rpc_req;
+    if (binary_rpc::parse_request_body(task->get_req()->get_body(), rpc_req)) {
+        auto route = _m_routes.find(rpc_req.server_uri);
+        if (route != _m_routes.end()) {
+            route->second->serve_rpc_process(task);
+            return;
+        }
+    }
+
+    std::string response_body;
+    binary_rpc::pack_response_head(static_cast<int32_t>(StatusCode::SERVER_RUN_FAILED), rpc_req.task_id, response_body);
+    task->get_resp()->set_body(std::move(response_body));
+}
+
+/***
+ *
+ */
+ModelServerHost::ModelServerHost() {
+    _m_impl = std::make_unique<Impl>();
+}
+
+/***
+ *
+ */
+ModelServerHost::~ModelServerHost() = default;
+
+/***
+ *
+ * @param server_section_name
+ * @param server_cfg
+ * @param server
+ * @return
+ */
+StatusCode ModelServerHost::add_server(
+    const std::string& server_section_name,
+    const decltype(toml::parse(""))& server_cfg,
+    std::unique_ptr<BaseAiServer> server) {
+    return _m_impl->add_server(server_section_name, server_cfg, std::move(server));
+}
+
+/***
+ *
+ * @param cfg
+ * @return
+ */
+jinq::common::StatusCode ModelServerHost::init(const decltype(toml::parse("")) &config) {
+    // init impl
+    auto status = _m_impl->init(config);
+    if (status != StatusCode::OK) {
+        LOG(INFO) << "init model server host failed";
+        return status;
+    }
+
+    // init shared thread pools, overrides settings of every hosted model server
+    WFGlobalSettings settings = GLOBAL_SETTINGS_DEFAULT;
+    settings.compute_threads = _m_impl->compute_threads;
+    settings.handler_threads = _m_impl->handler_threads;
+    settings.endpoint_params.max_connections = _m_impl->max_connection_nums;
+    settings.endpoint_params.response_timeout = _m_impl->peer_resp_timeout;
+    WORKFLOW_library_init(&settings);
+
+    // init shared http server
+    WFServerParams params = HTTP_SERVER_PARAMS_DEFAULT;
+    params.max_connections = _m_impl->max_connection_nums;
+    params.peer_response_timeout = _m_impl->peer_resp_timeout;
+    auto&& proc = std::bind(
+            &ModelServerHost::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
+    _m_server = std::make_unique<PeerAwareHttpServer>(&params, proc);
+
+    return StatusCode::OK;
+}
+
+/***
+ *
+ * @param task
+ */
+void ModelServerHost::serve_process(WFHttpTask* task) {
+    return _m_impl->serve_process(task);
+}
+
+/***
+ *
+ * @param task
+ */
+void ModelServerHost::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
+/***
+ *
+ * @return
+ */
+bool ModelServerHost::is_successfully_initialized() const {
+    return _m_impl->is_successfully_initialized();
+}
+}
+}
+}
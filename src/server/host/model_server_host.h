@@ -0,0 +1,95 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: model_server_host.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_MODEL_SERVER_HOST_H
+#define MM_AI_SERVER_MODEL_SERVER_HOST_H
+
+#include <memory>
+#include <string>
+
+#include "server/abstract_server.h"
+
+namespace jinq {
+namespace server {
+namespace host {
+/***
+ * Host several model servers in one process. All models share one WFHttpServer, one
+ * compute / handler thread pool and one connection budget, requests are routed by server_url
+ */
+class ModelServerHost : public jinq::server::BaseAiServer {
+public:
+
+    /***
+    * constructor
+    * @param config
+    */
+    ModelServerHost();
+
+    /***
+     *
+     */
+    ~ModelServerHost() override;
+
+    /***
+    * constructor
+    * @param transformer
+    */
+    ModelServerHost(const ModelServerHost& transformer) = delete;
+
+    /***
+     * constructor
+     * @param transformer
+     * @return
+     */
+    ModelServerHost& operator=(const ModelServerHost& transformer) = delete;
+
+    /***
+     * init model server and route its server_url to it, must be called before init
+     * @param server_section_name: server section in model server config, e.g. YOLOV5_DETECTION_SERVER
+     * @param server_cfg: model server config
+     * @param server: server created by ServerFactory
+     * @return
+     */
+    jinq::common::StatusCode add_server(
+        const std::string& server_section_name,
+        const decltype(toml::parse(""))& server_cfg,
+        std::unique_ptr<BaseAiServer> server);
+
+    /***
+     * init shared http server and thread pools
+     * @param toml
+     * @return
+     */
+    jinq::common::StatusCode init(const decltype(toml::parse(""))& cfg) override;
+
+    /***
+     *
+     * @param task
+     */
+    void serve_process(WFHttpTask* task) override;
+
+    /***
+     *
+     * @param task
+     */
+    void serve_rpc_process(WFBinaryRpcTask* task) override;
+
+    /***
+     *
+     * @return
+     */
+    bool is_successfully_initialized() const override;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> _m_impl;
+};
+}
+}
+}
+
+#endif //MM_AI_SERVER_MODEL_SERVER_HOST_H
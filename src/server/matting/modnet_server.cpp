@@ -33,9 +33,9 @@ using jinq::server::BaseAiServerImpl;
 namespace matting {
 
 using jinq::factory::matting::create_modnet_segmentor;
-using jinq::models::io_define::common_io::base64_input;
+using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::matting::std_matting_output;
-using ModNetPtr = decltype(create_modnet_segmentor<base64_input, std_matting_output>(""));
+using ModNetPtr = decltype(create_modnet_segmentor<mat_input, std_matting_output>(""));
 
 /************ Impl Declaration ************/
 
@@ -49,6 +49,14 @@ public:
     StatusCode init(const decltype(toml::parse(""))& config) override;
 
 protected:
+    /***
+     *
+     * @param config
+     * @param workers
+     * @return
+     */
+    StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<ModNetPtr>& workers) override;
+
     /***
      *
      * @param task_id
@@ -72,31 +80,11 @@ protected:
 StatusCode ModNetServer::Impl::init(const decltype(toml::parse("")) &config) {
     // init working queue
     auto server_section = config.at("MODNET_SERVER");
-    auto worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
-    auto model_cfg_path = config.at("MODNET").at("model_config_file_path").as_string();
-
-    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
-        LOG(FATAL) << "modnet model config file not exist: " << model_cfg_path;
+    if (init_working_queue(config) != StatusCode::OK) {
         _m_successfully_initialized = false;
         return StatusCode::SERVER_INIT_FAILED;
     }
 
-    auto model_cfg = toml::parse(model_cfg_path);
-
-    for (int index = 0; index < worker_nums; ++index) {
-        auto worker = create_modnet_segmentor<base64_input, std_matting_output>(
-                "worker_" + std::to_string(index + 1));
-
-        if (!worker->is_successfully_initialized()) {
-            if (worker->init(model_cfg) != StatusCode::OK) {
-                _m_successfully_initialized = false;
-                return StatusCode::SERVER_INIT_FAILED;
-            }
-        }
-
-        _m_working_queue.enqueue(std::move(worker));
-    }
-
     // init worker run timeout
     if (!server_section.contains("model_run_timeout")) {
         _m_model_run_timeout = 500; // ms
@@ -119,11 +107,50 @@ StatusCode ModNetServer::Impl::init(const decltype(toml::parse("")) &config) {
     compute_threads = static_cast<int>(server_section.at("compute_threads").as_integer());
     handler_threads = static_cast<int>(server_section.at("handler_threads").as_integer());
 
+    // init server options
+    if (init_server_options(server_section) != StatusCode::OK) {
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
     _m_successfully_initialized = true;
     LOG(INFO) << "modnet server init successfully";
     return StatusCode::OK;
 }
 
+/***
+ *
+ * @param config
+ * @param workers
+ * @return
+ */
+StatusCode ModNetServer::Impl::create_workers(const decltype(toml::parse("")) &config, std::vector<ModNetPtr>& workers) {
+    auto worker_nums = static_cast<int>(config.at("MODNET_SERVER").at("worker_nums").as_integer());
+    auto model_cfg_path = config.at("MODNET").at("model_config_file_path").as_string();
+
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "modnet model config file not exist: " << model_cfg_path;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    auto model_cfg = toml::parse(model_cfg_path);
+
+    for (int index = 0; index < worker_nums; ++index) {
+        auto worker = create_modnet_segmentor<mat_input, std_matting_output>(
+                "worker_" + std::to_string(index + 1));
+
+        if (!worker->is_successfully_initialized()) {
+            if (worker->init(model_cfg) != StatusCode::OK) {
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+        }
+
+        workers.push_back(std::move(worker));
+    }
+
+    return StatusCode::OK;
+}
+
 /***
  *
  * @param task_id
@@ -205,7 +232,7 @@ jinq::common::StatusCode ModNetServer::init(const decltype(toml::parse("")) &con
 
     auto&& proc = std::bind(
                       &ModNetServer::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
-    _m_server = std::make_unique<WFHttpServer>(proc);
+    _m_server = std::make_unique<PeerAwareHttpServer>(proc);
 
     return StatusCode::OK;
 }
@@ -218,6 +245,14 @@ void ModNetServer::serve_process(WFHttpTask* task) {
     return _m_impl->serve_process(task);
 }
 
+/***
+ *
+ * @param task
+ */
+void ModNetServer::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
 /***
  *
  * @return
@@ -31,9 +31,9 @@ using jinq::server::BaseAiServerImpl;
 namespace object_detection {
 
 using jinq::factory::object_detection::create_yolov5_detector;
-using jinq::models::io_define::common_io::base64_input;
+using jinq::models::io_define::common_io::mat_input;
 using jinq::models::io_define::object_detection::std_object_detection_output;
-using Yolov5DetPtr = decltype(create_yolov5_detector<base64_input, std_object_detection_output>(""));
+using Yolov5DetPtr = decltype(create_yolov5_detector<mat_input, std_object_detection_output>(""));
 
 class YoloV5DetServer::Impl : public BaseAiServerImpl<Yolov5DetPtr, std_object_detection_output> {
 public:
@@ -45,6 +45,14 @@ public:
     StatusCode init(const decltype(toml::parse(""))& config) override;
 
 protected:
+    /***
+     *
+     * @param config
+     * @param workers
+     * @return
+     */
+    StatusCode create_workers(const decltype(toml::parse(""))& config, std::vector<Yolov5DetPtr>& workers) override;
+
     /***
      *
      * @param task_id
@@ -66,31 +74,11 @@ protected:
 StatusCode YoloV5DetServer::Impl::init(const decltype(toml::parse("")) &config) {
     // init working queue
     auto server_section = config.at("YOLOV5_DETECTION_SERVER");
-    auto worker_nums = static_cast<int>(server_section.at("worker_nums").as_integer());
-    auto model_cfg_path = config.at("YOLOV5").at("model_config_file_path").as_string();
-
-    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
-        LOG(FATAL) << "yolov5 model config file not exist: " << model_cfg_path;
+    if (init_working_queue(config) != StatusCode::OK) {
         _m_successfully_initialized = false;
         return StatusCode::SERVER_INIT_FAILED;
     }
 
-    auto model_cfg = toml::parse(model_cfg_path);
-
-    for (int index = 0; index < worker_nums; ++index) {
-        auto worker = create_yolov5_detector<base64_input, std_object_detection_output>(
-                          "worker_" + std::to_string(index + 1));
-
-        if (!worker->is_successfully_initialized()) {
-            if (worker->init(model_cfg) != StatusCode::OK) {
-                _m_successfully_initialized = false;
-                return StatusCode::SERVER_INIT_FAILED;
-            }
-        }
-
-        _m_working_queue.enqueue(std::move(worker));
-    }
-
     // init worker run timeout
     if (!server_section.contains("model_run_timeout")) {
         _m_model_run_timeout = 500; // ms
@@ -113,11 +101,50 @@ StatusCode YoloV5DetServer::Impl::init(const decltype(toml::parse("")) &config)
     compute_threads = static_cast<int>(server_section.at("compute_threads").as_integer());
     handler_threads = static_cast<int>(server_section.at("handler_threads").as_integer());
 
+    // init server options
+    if (init_server_options(server_section) != StatusCode::OK) {
+        _m_successfully_initialized = false;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
     _m_successfully_initialized = true;
     LOG(INFO) << "Yolov5 object detection server init successfully";
     return StatusCode::OK;
 }
 
+/***
+ *
+ * @param config
+ * @param workers
+ * @return
+ */
+StatusCode YoloV5DetServer::Impl::create_workers(const decltype(toml::parse("")) &config, std::vector<Yolov5DetPtr>& workers) {
+    auto worker_nums = static_cast<int>(config.at("YOLOV5_DETECTION_SERVER").at("worker_nums").as_integer());
+    auto model_cfg_path = config.at("YOLOV5").at("model_config_file_path").as_string();
+
+    if (!FilePathUtil::is_file_exist(model_cfg_path)) {
+        LOG(ERROR) << "yolov5 model config file not exist: " << model_cfg_path;
+        return StatusCode::SERVER_INIT_FAILED;
+    }
+
+    auto model_cfg = toml::parse(model_cfg_path);
+
+    for (int index = 0; index < worker_nums; ++index) {
+        auto worker = create_yolov5_detector<mat_input, std_object_detection_output>(
+                          "worker_" + std::to_string(index + 1));
+
+        if (!worker->is_successfully_initialized()) {
+            if (worker->init(model_cfg) != StatusCode::OK) {
+                return StatusCode::SERVER_INIT_FAILED;
+            }
+        }
+
+        workers.push_back(std::move(worker));
+    }
+
+    return StatusCode::OK;
+}
+
 /***
  *
  * @param task_id
@@ -223,7 +250,7 @@ jinq::common::StatusCode YoloV5DetServer::init(const decltype(toml::parse("")) &
 
     auto&& proc = std::bind(
             &YoloV5DetServer::Impl::serve_process, std::cref(this->_m_impl), std::placeholders::_1);
-    _m_server = std::make_unique<WFHttpServer>(proc);
+    _m_server = std::make_unique<PeerAwareHttpServer>(proc);
 
     return StatusCode::OK;
 }
@@ -236,6 +263,14 @@ void YoloV5DetServer::serve_process(WFHttpTask* task) {
     return _m_impl->serve_process(task);
 }
 
+/***
+ *
+ * @param task
+ */
+void YoloV5DetServer::serve_rpc_process(WFBinaryRpcTask* task) {
+    return _m_impl->serve_rpc_process(task);
+}
+
 /***
  *
  * @return
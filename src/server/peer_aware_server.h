@@ -0,0 +1,67 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: peer_aware_server.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_PEER_AWARE_SERVER_H
+#define MM_AI_SERVER_PEER_AWARE_SERVER_H
+
+#include <workflow/WFTask.h>
+#include <workflow/WFServer.h>
+#include <workflow/WFHttpServer.h>
+
+namespace jinq {
+namespace server {
+
+/***
+ * Server which remembers the accepted socket of every connection in the connection context,
+ * so that a task still waiting for a model worker can find out its client has gone away.
+ * Workflow keeps the connection entry alive until the task replied, the fd can not be reused
+ * by another connection while the task is in process
+ * @tparam REQ
+ * @tparam RESP
+ */
+template<class REQ, class RESP>
+class PeerAwareServer : public WFServer<REQ, RESP> {
+public:
+    using WFServer<REQ, RESP>::WFServer;
+
+protected:
+    /***
+     *
+     * @param accept_fd
+     * @return
+     */
+    WFConnection* new_connection(int accept_fd) override {
+        auto* conn = WFServer<REQ, RESP>::new_connection(accept_fd);
+        if (conn != nullptr) {
+            conn->set_context(new int(accept_fd), [](void* fd) { delete static_cast<int*>(fd); });
+        }
+        return conn;
+    }
+};
+
+using PeerAwareHttpServer = PeerAwareServer<protocol::HttpRequest, protocol::HttpResponse>;
+
+/***
+ * accepted socket of the connection the task came from
+ * @tparam REQ
+ * @tparam RESP
+ * @param task
+ * @return -1 if task was not served by a PeerAwareServer
+ */
+template<class REQ, class RESP>
+inline int get_peer_fd(WFNetworkTask<REQ, RESP>* task) {
+    auto* conn = task->get_connection();
+    if (conn == nullptr || conn->get_context() == nullptr) {
+        return -1;
+    }
+    return *static_cast<int*>(conn->get_context());
+}
+
+}
+}
+
+#endif //MM_AI_SERVER_PEER_AWARE_SERVER_H
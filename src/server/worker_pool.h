@@ -0,0 +1,403 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: worker_pool.h
+* Date: 26-10-16
+************************************************/
+
+#ifndef MM_AI_SERVER_WORKER_POOL_H
+#define MM_AI_SERVER_WORKER_POOL_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace jinq {
+namespace server {
+
+/***
+ * Model worker pool. Callers waiting for a worker are parked instead of spinning and
+ * get served earliest deadline first, callers without deadline are served in arrival order
+ * after them. A returned worker is handed over to the most urgent waiter. Workers can be
+ * swapped with a new generation, busy workers of old generation are dropped once returned.
+ * Callers may belong to tenants, each tenant has its own waiter queue and workers are shared
+ * among tenants with waiters in weighted fair order
+ * @tparam WORKER
+ */
+template<typename WORKER>
+class WorkerPool {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+
+    struct tenant_stat {
+        size_t waiting = 0;
+        size_t running = 0;
+        size_t served = 0;
+    };
+
+    /***
+     *
+     */
+    WorkerPool() = default;
+
+    /***
+     *
+     */
+    ~WorkerPool() = default;
+
+    /***
+     *
+     * @param transformer
+     */
+    WorkerPool(const WorkerPool& transformer) = delete;
+
+    /***
+     *
+     * @param transformer
+     * @return
+     */
+    WorkerPool& operator=(const WorkerPool& transformer) = delete;
+
+    /***
+     * put worker back into pool, wake up the most urgent waiter if there is any
+     * @param worker
+     */
+    void enqueue(WORKER&& worker) {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        hand_over(std::move(worker));
+    }
+
+    /***
+     * put worker of given generation back into pool, it is dropped if workers were swapped since dequeue
+     * @param worker
+     * @param generation
+     */
+    void enqueue(WORKER&& worker, size_t generation) {
+        std::unique_lock<std::mutex> lock(_m_mutex);
+
+        if (generation != _m_generation) {
+            // release retired worker out of lock
+            lock.unlock();
+            WORKER retired_worker = std::move(worker);
+            return;
+        }
+        hand_over(std::move(worker));
+    }
+
+    /***
+     * put worker fetched for tenant back into pool and free the tenant's running slot
+     * @param worker
+     * @param generation
+     * @param tenant
+     */
+    void enqueue(WORKER&& worker, size_t generation, size_t tenant) {
+        {
+            std::lock_guard<std::mutex> lock(_m_mutex);
+            auto& queue = _m_tenants[tenant < _m_tenants.size() ? tenant : 0];
+            if (queue.running > 0) {
+                queue.running--;
+            }
+            // freed slot may let waiters of a capped tenant take idle workers
+            dispatch_idle_workers();
+        }
+        enqueue(std::move(worker), generation);
+    }
+
+    /***
+     * fetch a worker, block until one is available
+     * @param worker
+     */
+    void dequeue(WORKER& worker) {
+        dequeue(worker, time_point::max());
+    }
+
+    /***
+     * fetch a worker, block until one is available
+     * @param worker
+     * @param generation: generation of the fetched worker
+     */
+    void dequeue(WORKER& worker, size_t& generation) {
+        dequeue(worker, time_point::max(), &generation);
+    }
+
+    /***
+     * fetch a worker before deadline, waiters with earlier deadline are served first
+     * @param worker
+     * @param deadline
+     * @param generation: generation of the fetched worker, may be null
+     * @return false if deadline passed before a worker was available
+     */
+    bool dequeue(WORKER& worker, const time_point& deadline, size_t* generation = nullptr) {
+        return dequeue(worker, deadline, generation, 0, false);
+    }
+
+    /***
+     * fetch a worker for tenant before deadline, the worker takes one of the tenant's running
+     * slots until it is put back by enqueue with the same tenant
+     * @param worker
+     * @param deadline
+     * @param generation: generation of the fetched worker, may be null
+     * @param tenant
+     * @return false if deadline passed before a worker was available
+     */
+    bool dequeue(WORKER& worker, const time_point& deadline, size_t* generation, size_t tenant) {
+        return dequeue(worker, deadline, generation, tenant, true);
+    }
+
+    /***
+     * fetch a worker without blocking
+     * @param worker
+     * @return false if no worker is available
+     */
+    bool try_dequeue(WORKER& worker) {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+
+        if (_m_idle_workers.empty() || select_tenant() != nullptr) {
+            return false;
+        }
+
+        worker = std::move(_m_idle_workers.front());
+        _m_idle_workers.pop_front();
+        return true;
+    }
+
+    /***
+     * replace all workers with a new generation. New workers are handed over to waiters at once,
+     * idle workers of old generation are returned and busy ones are dropped once they come back
+     * @param workers: new workers in, retired idle workers out
+     */
+    void swap_workers(std::vector<WORKER>& workers) {
+        std::vector<WORKER> retired_workers;
+        std::unique_lock<std::mutex> lock(_m_mutex);
+
+        _m_generation++;
+        for (auto& idle_worker : _m_idle_workers) {
+            retired_workers.push_back(std::move(idle_worker));
+        }
+        _m_idle_workers.clear();
+
+        for (auto& worker : workers) {
+            hand_over(std::move(worker));
+        }
+        lock.unlock();
+
+        workers.swap(retired_workers);
+    }
+
+    /***
+     *
+     * @return
+     */
+    size_t generation() const {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        return _m_generation;
+    }
+
+    /***
+     * idle worker nums
+     * @return
+     */
+    size_t size_approx() const {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        return _m_idle_workers.size();
+    }
+
+    /***
+     * callers waiting for a worker
+     * @return
+     */
+    size_t waiting_nums() const {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        return _m_waiter_nums;
+    }
+
+    /***
+     * set weight and max concurrency of tenant. Tenant 0 is the default one, callers without
+     * tenant belong to it
+     * @param tenant
+     * @param weight: share of workers while several tenants are waiting
+     * @param max_concurrency: max workers held by the tenant at a time, 0 means no limit
+     */
+    void configure_tenant(size_t tenant, double weight, size_t max_concurrency) {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        if (tenant >= _m_tenants.size()) {
+            _m_tenants.resize(tenant + 1);
+        }
+        _m_tenants[tenant].weight = weight > 0 ? weight : 1.0;
+        _m_tenants[tenant].max_concurrency = max_concurrency;
+        dispatch_idle_workers();
+    }
+
+    /***
+     *
+     * @param tenant
+     * @return
+     */
+    tenant_stat get_tenant_stat(size_t tenant) const {
+        std::lock_guard<std::mutex> lock(_m_mutex);
+        tenant_stat stat;
+        if (tenant < _m_tenants.size()) {
+            stat.waiting = _m_tenants[tenant].waiters.size();
+            stat.running = _m_tenants[tenant].running;
+            stat.served = _m_tenants[tenant].served;
+        }
+        return stat;
+    }
+
+private:
+    struct waiter_node {
+        std::condition_variable cv;
+        WORKER worker;
+        time_point deadline;
+        size_t generation = 0;
+        bool accounted = false;
+        bool ready = false;
+    };
+
+    struct tenant_queue {
+        double weight = 1.0;
+        size_t max_concurrency = 0;
+        // virtual time of tenant, advanced by 1 / weight every time one of its waiters is served
+        double pass = 0.0;
+        size_t running = 0;
+        size_t served = 0;
+        // ordered by deadline, equal deadlines stay in arrival order
+        std::deque<waiter_node*> waiters;
+    };
+
+    /***
+     *
+     * @param worker
+     * @param deadline
+     * @param generation
+     * @param tenant
+     * @param accounted: whether the worker takes a running slot of the tenant
+     * @return
+     */
+    bool dequeue(WORKER& worker, const time_point& deadline, size_t* generation, size_t tenant, bool accounted) {
+        std::unique_lock<std::mutex> lock(_m_mutex);
+
+        if (deadline != time_point::max() && clock_type::now() >= deadline) {
+            return false;
+        }
+        tenant = tenant < _m_tenants.size() ? tenant : 0;
+        auto& queue = _m_tenants[tenant];
+        bool under_limit = !accounted || queue.max_concurrency == 0 || queue.running < queue.max_concurrency;
+        if (queue.waiters.empty() && under_limit && !_m_idle_workers.empty()) {
+            worker = std::move(_m_idle_workers.front());
+            _m_idle_workers.pop_front();
+            if (accounted) {
+                queue.running++;
+            }
+            queue.served++;
+            if (generation != nullptr) {
+                *generation = _m_generation;
+            }
+            return true;
+        }
+
+        // tenant becoming active must not bank credit from the time it was idle
+        if (queue.waiters.empty()) {
+            queue.pass = std::max(queue.pass, _m_virtual_time);
+        }
+        waiter_node waiter;
+        waiter.deadline = deadline;
+        waiter.accounted = accounted;
+        auto pos = std::upper_bound(
+            queue.waiters.begin(), queue.waiters.end(), &waiter, [](const waiter_node* lhs, const waiter_node* rhs) {
+                return lhs->deadline < rhs->deadline;
+            });
+        queue.waiters.insert(pos, &waiter);
+        _m_waiter_nums++;
+
+        if (deadline == time_point::max()) {
+            waiter.cv.wait(lock, [&waiter] { return waiter.ready; });
+        } else if (!waiter.cv.wait_until(lock, deadline, [&waiter] { return waiter.ready; })) {
+            // tenants may have been resized while waiting, look the queue up again
+            auto& waiters = _m_tenants[tenant].waiters;
+            waiters.erase(std::find(waiters.begin(), waiters.end(), &waiter));
+            _m_waiter_nums--;
+            return false;
+        }
+        worker = std::move(waiter.worker);
+        if (generation != nullptr) {
+            *generation = waiter.generation;
+        }
+        return true;
+    }
+
+    /***
+     * tenant with waiters and a free running slot which is furthest behind in virtual time
+     * @return null if there is none
+     */
+    tenant_queue* select_tenant() {
+        tenant_queue* selected = nullptr;
+        for (auto& queue : _m_tenants) {
+            if (queue.waiters.empty()) {
+                continue;
+            }
+            if (queue.max_concurrency > 0 && queue.running >= queue.max_concurrency
+                    && queue.waiters.front()->accounted) {
+                continue;
+            }
+            if (selected == nullptr || queue.pass < selected->pass) {
+                selected = &queue;
+            }
+        }
+        return selected;
+    }
+
+    /***
+     * hand worker over to the most urgent waiter of the selected tenant or keep it idle
+     * @param worker
+     */
+    void hand_over(WORKER&& worker) {
+        auto* queue = select_tenant();
+        if (queue == nullptr) {
+            _m_idle_workers.push_back(std::move(worker));
+            return;
+        }
+
+        auto* waiter = queue->waiters.front();
+        queue->waiters.pop_front();
+        _m_waiter_nums--;
+        _m_virtual_time = queue->pass;
+        queue->pass += 1.0 / queue->weight;
+        if (waiter->accounted) {
+            queue->running++;
+        }
+        queue->served++;
+        waiter->worker = std::move(worker);
+        waiter->generation = _m_generation;
+        waiter->ready = true;
+        // notify under lock, waiter node is gone as soon as the waiter returns
+        waiter->cv.notify_one();
+    }
+
+    /***
+     * hand idle workers over to waiters which became eligible
+     */
+    void dispatch_idle_workers() {
+        while (!_m_idle_workers.empty() && select_tenant() != nullptr) {
+            WORKER worker = std::move(_m_idle_workers.front());
+            _m_idle_workers.pop_front();
+            hand_over(std::move(worker));
+        }
+    }
+
+    mutable std::mutex _m_mutex;
+    std::deque<WORKER> _m_idle_workers;
+    std::vector<tenant_queue> _m_tenants = std::vector<tenant_queue>(1);
+    size_t _m_waiter_nums = 0;
+    double _m_virtual_time = 0.0;
+    size_t _m_generation = 0;
+};
+
+}
+}
+
+#endif //MM_AI_SERVER_WORKER_POOL_H
@@ -0,0 +1,122 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: access_logger_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/access_logger.h"
+
+using jinq::common::AccessLogger;
+using jinq::common::access_log_entry;
+
+namespace {
+
+struct line_collector {
+    std::mutex mutex;
+    std::vector<std::string> batches;
+
+    AccessLogger::sink_type sink() {
+        return [this](const std::string& lines) {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(lines);
+        };
+    }
+
+    size_t line_nums() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t nums = 0;
+        for (const auto& batch : batches) {
+            nums += std::count(batch.begin(), batch.end(), '\n') + 1;
+        }
+        return nums;
+    }
+};
+
+access_log_entry make_entry(const std::string& task_id, uint64_t finished_us) {
+    access_log_entry entry;
+    entry.task_id = task_id;
+    entry.received_us = finished_us - 1000;
+    entry.finished_us = finished_us;
+    entry.elapse_ms = 1.5;
+    return entry;
+}
+}
+
+TEST(access_logger_unittest, structured_fields) {
+    line_collector collector;
+    AccessLogger logger("/yolov5", collector.sink(), 1.0, 60000, 16);
+    EXPECT_EQ(logger.log(make_entry("task_2", 2000000)), true);
+    EXPECT_EQ(logger.log(make_entry("task_1", 1000000)), true);
+    logger.flush();
+
+    ASSERT_EQ(collector.batches.size(), 1);
+    const auto& lines = collector.batches[0];
+    auto task_1 = lines.find("server=/yolov5 task_id=task_1 received_at=");
+    auto task_2 = lines.find("server=/yolov5 task_id=task_2 received_at=");
+    ASSERT_NE(task_1, std::string::npos);
+    ASSERT_NE(task_2, std::string::npos);
+    // ordered by finish time
+    EXPECT_LT(task_1, task_2);
+    EXPECT_NE(lines.find("status=0 elapse_ms=1.500"), std::string::npos);
+    EXPECT_EQ(logger.written(), 2);
+}
+
+TEST(access_logger_unittest, sampling) {
+    line_collector collector;
+    AccessLogger logger("/yolov5", collector.sink(), 0.25, 60000, 16);
+    int sampled = 0;
+    for (int i = 0; i < 100; ++i) {
+        sampled += logger.sample() ? 1 : 0;
+    }
+    EXPECT_EQ(sampled, 25);
+
+    AccessLogger silent_logger("/yolov5", collector.sink(), 0, 60000, 16);
+    EXPECT_EQ(silent_logger.sample(), false);
+}
+
+TEST(access_logger_unittest, drop_when_full) {
+    line_collector collector;
+    AccessLogger logger("/yolov5", collector.sink(), 1.0, 60000, 4);
+    for (int i = 0; i < 6; ++i) {
+        logger.log(make_entry("task_" + std::to_string(i), 1000000 + i));
+    }
+    EXPECT_EQ(logger.dropped(), 2);
+    logger.flush();
+    EXPECT_EQ(logger.written(), 4);
+    ASSERT_EQ(collector.batches.size(), 1);
+    EXPECT_NE(collector.batches[0].find("access_log_dropped=2"), std::string::npos);
+
+    // room again once drained
+    EXPECT_EQ(logger.log(make_entry("task_6", 2000000)), true);
+}
+
+TEST(access_logger_unittest, background_flush) {
+    line_collector collector;
+    {
+        AccessLogger logger("/yolov5", collector.sink(), 1.0, 10, 1024);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < 200; ++i) {
+                    logger.log(make_entry("task_" + std::to_string(t) + "_" + std::to_string(i), 1000000 + i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(logger.written(), 800);
+    }
+    EXPECT_EQ(collector.line_nums(), 800);
+}
@@ -25,6 +25,27 @@ TEST(base64_unnittest, encode) {
     EXPECT_STREQ(Base64::base64_encode("foobar").c_str(), "Zm9vYmFy");
 }
 
+TEST(base64_unnittest, decode) {
+    EXPECT_STREQ(Base64::base64_decode("").c_str(), "");
+    EXPECT_STREQ(Base64::base64_decode("Zg==").c_str(), "f");
+    EXPECT_STREQ(Base64::base64_decode("Zm8=").c_str(), "fo");
+    EXPECT_STREQ(Base64::base64_decode("Zm9v").c_str(), "foo");
+    EXPECT_STREQ(Base64::base64_decode("Zm9vYg==").c_str(), "foob");
+    EXPECT_STREQ(Base64::base64_decode("Zm9vYmE=").c_str(), "fooba");
+    EXPECT_STREQ(Base64::base64_decode("Zm9vYmFy").c_str(), "foobar");
+    // decoding stops at the first non base64 char
+    EXPECT_STREQ(Base64::base64_decode("Zm9v\"Ym").c_str(), "foo");
+
+    std::string binary;
+    for (int i = 0; i < 1000; ++i) {
+        binary += static_cast<char>(i * 7 % 256);
+    }
+    auto encoded = Base64::base64_encode(binary);
+    std::string decoded;
+    EXPECT_EQ(Base64::base64_decode(encoded.data(), encoded.size(), decoded), binary.size());
+    EXPECT_EQ(decoded, binary);
+}
+
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,47 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_affinity_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/cpu_affinity.h"
+
+using jinq::common::CpuAffinity;
+using jinq::common::ScopedCpuAffinity;
+
+TEST(cpu_affinity_unittest, parse_cpu_list) {
+    EXPECT_EQ(CpuAffinity::parse_cpu_list("0-3,8,10-11\n"), std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuAffinity::parse_cpu_list("5"), std::vector<int>({5}));
+    EXPECT_TRUE(CpuAffinity::parse_cpu_list("").empty());
+}
+
+TEST(cpu_affinity_unittest, worker_cores) {
+    std::vector<int> cores = {0, 2, 4, 6, 1, 3, 5, 7};
+    EXPECT_EQ(CpuAffinity::worker_cores(cores, 0, 2, 0), std::vector<int>({0, 2}));
+    EXPECT_EQ(CpuAffinity::worker_cores(cores, 1, 2, 0), std::vector<int>({4, 6}));
+    EXPECT_EQ(CpuAffinity::worker_cores(cores, 1, 2, 2), std::vector<int>({1, 3}));
+    // wrap around
+    EXPECT_EQ(CpuAffinity::worker_cores(cores, 4, 2, 0), std::vector<int>({0, 2}));
+    EXPECT_TRUE(CpuAffinity::worker_cores(cores, 0, 0, 0).empty());
+}
+
+TEST(cpu_affinity_unittest, scoped_affinity) {
+    std::vector<int> origin_cores;
+    if (!CpuAffinity::current_thread_cores(origin_cores) || origin_cores.empty()) {
+        return;
+    }
+    {
+        ScopedCpuAffinity affinity({origin_cores.front()});
+        std::vector<int> bound_cores;
+        EXPECT_EQ(CpuAffinity::current_thread_cores(bound_cores), true);
+        EXPECT_EQ(bound_cores, std::vector<int>({origin_cores.front()}));
+    }
+    std::vector<int> restored_cores;
+    EXPECT_EQ(CpuAffinity::current_thread_cores(restored_cores), true);
+    EXPECT_EQ(restored_cores, origin_cores);
+}
@@ -0,0 +1,37 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: cpu_usage_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/cpu_usage.h"
+
+using jinq::common::CpuUsageSampler;
+
+TEST(cpu_usage_unittest, parse_proc_stat) {
+    uint64_t busy_ticks = 0;
+    uint64_t total_ticks = 0;
+    EXPECT_EQ(CpuUsageSampler::parse_proc_stat("cpu  10 2 8 70 10 0 0 0 0 0", busy_ticks, total_ticks), true);
+    EXPECT_EQ(total_ticks, 100);
+    EXPECT_EQ(busy_ticks, 20);
+
+    EXPECT_EQ(CpuUsageSampler::parse_proc_stat("cpu0 10 2 8 70 10", busy_ticks, total_ticks), false);
+    EXPECT_EQ(CpuUsageSampler::parse_proc_stat("cpu 10 2", busy_ticks, total_ticks), false);
+}
+
+TEST(cpu_usage_unittest, sample) {
+    CpuUsageSampler sampler;
+    // first sample only sets the baseline
+    EXPECT_LT(sampler.sample(), 0.0);
+    volatile uint64_t sum = 0;
+    for (uint64_t index = 0; index < 50000000; ++index) {
+        sum += index;
+    }
+    auto usage = sampler.sample();
+    if (usage >= 0.0) {
+        EXPECT_LE(usage, 1.0);
+    }
+}
@@ -0,0 +1,35 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: hash_util_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "common/hash_util.h"
+
+using jinq::common::hash_util::murmur_hash64;
+
+TEST(hash_util_unittest, murmur_hash64) {
+    std::string image_bytes(1027, '\0');
+    for (size_t index = 0; index < image_bytes.size(); ++index) {
+        image_bytes[index] = static_cast<char>(index * 31);
+    }
+
+    EXPECT_EQ(murmur_hash64(image_bytes), murmur_hash64(image_bytes.data(), image_bytes.size()));
+    EXPECT_NE(murmur_hash64(image_bytes), murmur_hash64(image_bytes, 1));
+    EXPECT_NE(murmur_hash64(image_bytes), murmur_hash64(image_bytes.data(), image_bytes.size() - 1));
+
+    auto modified_bytes = image_bytes;
+    modified_bytes[1026] ^= 1;
+    EXPECT_NE(murmur_hash64(image_bytes), murmur_hash64(modified_bytes));
+    EXPECT_NE(murmur_hash64(""), murmur_hash64("", 1));
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
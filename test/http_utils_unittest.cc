@@ -0,0 +1,95 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: http_utils_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "common/http_utils.h"
+
+using jinq::common::http_util::MultipartParser;
+using jinq::common::http_util::MultipartReader;
+using jinq::common::http_util::accepts_encoding;
+using jinq::common::http_util::gzip_compress;
+
+TEST(http_utils_unittest, multipart_reader) {
+    MultipartParser parser;
+    parser.add_parameter("req_id", "test_req_id");
+    parser.add_parameter("img_data", std::string("\x89PNG\r\n\x00\x01", 8));
+    auto body = parser.gen_body_content();
+
+    MultipartReader reader("multipart/form-data; boundary=" + parser.boundary());
+    EXPECT_STREQ(reader.boundary().c_str(), parser.boundary().c_str());
+    ASSERT_EQ(reader.parse(body.data(), body.size()), true);
+    ASSERT_EQ(reader.fields().size(), 2);
+
+    auto* req_id = reader.find_field("req_id");
+    ASSERT_NE(req_id, nullptr);
+    EXPECT_STREQ(std::string(req_id->data, req_id->size).c_str(), "test_req_id");
+
+    auto* img_data = reader.find_field("img_data");
+    ASSERT_NE(img_data, nullptr);
+    EXPECT_EQ(std::string(img_data->data, img_data->size), std::string("\x89PNG\r\n\x00\x01", 8));
+    EXPECT_EQ(reader.find_field("not_exist"), nullptr);
+}
+
+TEST(http_utils_unittest, multipart_reader_file_field) {
+    std::string body = "--abc\r\n"
+                       "Content-Disposition: form-data; name=\"img_data\"; filename=\"test.jpg\"\r\n"
+                       "Content-Type: image/jpeg\r\n\r\n"
+                       "jpeg bytes\r\n"
+                       "--abc--\r\n";
+    MultipartReader reader("multipart/form-data; boundary=\"abc\"");
+    ASSERT_EQ(reader.parse(body.data(), body.size()), true);
+    ASSERT_EQ(reader.fields().size(), 1);
+    EXPECT_STREQ(reader.fields()[0].name.c_str(), "img_data");
+    EXPECT_STREQ(reader.fields()[0].file_name.c_str(), "test.jpg");
+    EXPECT_STREQ(reader.fields()[0].content_type.c_str(), "image/jpeg");
+    EXPECT_EQ(std::string(reader.fields()[0].data, reader.fields()[0].size), "jpeg bytes");
+
+    std::string truncated_body = body.substr(0, body.size() - 12);
+    EXPECT_EQ(reader.parse(truncated_body.data(), truncated_body.size()), false);
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+TEST(http_utils_unittest, accepts_encoding) {
+    EXPECT_EQ(accepts_encoding("gzip, deflate, br", "gzip"), true);
+    EXPECT_EQ(accepts_encoding("deflate, GZip;q=0.5", "gzip"), true);
+    EXPECT_EQ(accepts_encoding("gzip;q=0, *", "gzip"), false);
+    EXPECT_EQ(accepts_encoding("br, *;q=0.1", "gzip"), true);
+    EXPECT_EQ(accepts_encoding("identity", "gzip"), false);
+    EXPECT_EQ(accepts_encoding("", "gzip"), false);
+}
+
+TEST(http_utils_unittest, gzip_compress) {
+    std::string body;
+    for (int i = 0; i < 1000; ++i) {
+        body += "{\"code\": 0, \"msg\": \"success\"}";
+    }
+    std::string compressed;
+    ASSERT_EQ(gzip_compress(body.data(), body.size(), 6, compressed), true);
+    EXPECT_LT(compressed.size(), body.size() / 10);
+    // gzip magic
+    EXPECT_EQ(static_cast<unsigned char>(compressed[0]), 0x1f);
+    EXPECT_EQ(static_cast<unsigned char>(compressed[1]), 0x8b);
+
+    z_stream stream{};
+    ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    std::string decompressed(body.size(), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&decompressed[0]);
+    stream.avail_out = static_cast<uInt>(decompressed.size());
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&stream);
+    EXPECT_EQ(decompressed, body);
+}
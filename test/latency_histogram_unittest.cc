@@ -0,0 +1,47 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: latency_histogram_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "common/latency_histogram.h"
+
+using jinq::common::LatencyHistogram;
+
+TEST(latency_histogram_unittest, observe) {
+    LatencyHistogram histogram({1, 10, 100});
+    histogram.observe(0.5);
+    histogram.observe(1);
+    histogram.observe(50);
+    histogram.observe(1000);
+
+    EXPECT_EQ(histogram.count(), 4);
+    EXPECT_NEAR(histogram.sum(), 1051.5, 1e-3);
+}
+
+TEST(latency_histogram_unittest, to_prometheus) {
+    LatencyHistogram histogram({1, 10});
+    histogram.observe(0.5);
+    histogram.observe(5);
+    histogram.observe(20);
+
+    std::string output;
+    histogram.to_prometheus("latency_ms", "stage=\"infer\"", output);
+    std::string expect_output =
+        "latency_ms_bucket{stage=\"infer\",le=\"1\"} 1\n"
+        "latency_ms_bucket{stage=\"infer\",le=\"10\"} 2\n"
+        "latency_ms_bucket{stage=\"infer\",le=\"+Inf\"} 3\n"
+        "latency_ms_sum{stage=\"infer\"} 25.5\n"
+        "latency_ms_count{stage=\"infer\"} 3\n";
+    EXPECT_STREQ(output.c_str(), expect_output.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
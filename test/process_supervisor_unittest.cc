@@ -0,0 +1,78 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: process_supervisor_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "common/process_supervisor.h"
+
+using jinq::common::ProcessSupervisor;
+
+TEST(process_supervisor_unittest, fork_children) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    ProcessSupervisor supervisor(3, 10);
+    int process_index = -1;
+    if (supervisor.run(process_index)) {
+        char index = static_cast<char>(process_index);
+        _exit(write(fds[1], &index, 1) == 1 ? 0 : 1);
+    }
+    close(fds[1]);
+    EXPECT_EQ(supervisor.is_failed(), false);
+    EXPECT_EQ(supervisor.restart_nums(), 0);
+
+    std::set<int> indexes;
+    char index = 0;
+    while (read(fds[0], &index, 1) == 1) {
+        indexes.insert(index);
+    }
+    close(fds[0]);
+    EXPECT_EQ(indexes, std::set<int>({0, 1, 2}));
+}
+
+TEST(process_supervisor_unittest, restart_failed_child) {
+    std::string marker = "/tmp/mortred_process_supervisor_unittest_" + std::to_string(getpid());
+    unlink(marker.c_str());
+
+    ProcessSupervisor supervisor(2, 10);
+    int process_index = -1;
+    if (supervisor.run(process_index)) {
+        // second child fails on its first run only
+        if (process_index == 1 && access(marker.c_str(), F_OK) != 0) {
+            close(open(marker.c_str(), O_CREAT | O_WRONLY, 0600));
+            _exit(3);
+        }
+        _exit(0);
+    }
+    EXPECT_EQ(supervisor.is_failed(), false);
+    EXPECT_EQ(supervisor.restart_nums(), 1);
+    unlink(marker.c_str());
+}
+
+TEST(process_supervisor_unittest, restart_crashed_child) {
+    std::string marker = "/tmp/mortred_process_supervisor_crash_" + std::to_string(getpid());
+    unlink(marker.c_str());
+
+    ProcessSupervisor supervisor(1, 10);
+    int process_index = -1;
+    if (supervisor.run(process_index)) {
+        if (access(marker.c_str(), F_OK) != 0) {
+            close(open(marker.c_str(), O_CREAT | O_WRONLY, 0600));
+            kill(getpid(), SIGKILL);
+        }
+        _exit(0);
+    }
+    EXPECT_EQ(supervisor.restart_nums(), 1);
+    unlink(marker.c_str());
+}
@@ -0,0 +1,74 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: result_cache_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/result_cache.h"
+
+using jinq::common::ResultCache;
+
+TEST(result_cache_unittest, get_put) {
+    ResultCache cache(1024 * 1024, 0);
+    std::string value;
+    EXPECT_EQ(cache.get(1, value), false);
+
+    cache.put(1, "result_1");
+    EXPECT_EQ(cache.get(1, value), true);
+    EXPECT_EQ(value, "result_1");
+
+    cache.put(1, "result_1_updated");
+    EXPECT_EQ(cache.get(1, value), true);
+    EXPECT_EQ(value, "result_1_updated");
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.hits(), 2);
+    EXPECT_EQ(cache.misses(), 1);
+}
+
+TEST(result_cache_unittest, lru_eviction) {
+    ResultCache probe(1024 * 1024, 0);
+    probe.put(0, std::string(100, 'x'));
+    auto entry_bytes = probe.bytes();
+
+    // room for two entries only
+    ResultCache cache(entry_bytes * 2, 0);
+    std::string value;
+    cache.put(1, std::string(100, 'a'));
+    cache.put(2, std::string(100, 'b'));
+    EXPECT_EQ(cache.get(1, value), true);
+    cache.put(3, std::string(100, 'c'));
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_LE(cache.bytes(), entry_bytes * 2);
+    EXPECT_EQ(cache.get(2, value), false);
+    EXPECT_EQ(cache.get(1, value), true);
+    EXPECT_EQ(cache.get(3, value), true);
+
+    // value exceeding memory budget is never cached
+    cache.put(4, std::string(entry_bytes * 2, 'd'));
+    EXPECT_EQ(cache.get(4, value), false);
+}
+
+TEST(result_cache_unittest, ttl_expire) {
+    ResultCache cache(1024 * 1024, 10);
+    std::string value;
+    cache.put(1, "result_1");
+    EXPECT_EQ(cache.get(1, value), true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(cache.get(1, value), false);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.bytes(), 0);
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
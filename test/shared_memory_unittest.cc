@@ -0,0 +1,43 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: shared_memory_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "common/shared_memory.h"
+
+using jinq::common::SharedMemoryRegion;
+
+TEST(shared_memory_unittest, open_region) {
+    std::string name = "/mortred_shm_unittest_" + std::to_string(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 8192), 0);
+    auto* mapping = static_cast<char*>(mmap(nullptr, 8192, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    ASSERT_NE(mapping, MAP_FAILED);
+    std::memcpy(mapping + 5000, "frame", 5);
+
+    SharedMemoryRegion region;
+    EXPECT_EQ(region.open(name, 5000, 5), true);
+    EXPECT_EQ(region.size(), 5);
+    EXPECT_EQ(std::string(region.data(), region.size()), "frame");
+
+    // region beyond segment end
+    EXPECT_EQ(region.open(name, 8000, 1000), false);
+    EXPECT_EQ(region.data(), nullptr);
+    EXPECT_EQ(region.open("/mortred_shm_unittest_missing", 0, 1), false);
+
+    munmap(mapping, 8192);
+    close(fd);
+    shm_unlink(name.c_str());
+}
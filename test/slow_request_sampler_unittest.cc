@@ -0,0 +1,107 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: slow_request_sampler_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/slow_request_sampler.h"
+
+using jinq::common::SlowRequestSampler;
+using jinq::common::slow_request_record;
+
+namespace {
+
+std::string test_prefix(const std::string& name) {
+    return "/tmp/mortred_slow_request_" + name + "_" + std::to_string(getpid());
+}
+
+slow_request_record make_record(const std::string& task_id, double total_ms) {
+    slow_request_record record;
+    record.server_uri = "/mortred_ai_server_v1/obj_detection/yolov5";
+    record.task_id = task_id;
+    record.worker_id = 1;
+    record.total_ms = total_ms;
+    record.stage_ms.emplace_back("model_run", total_ms / 2);
+    record.image_data = std::string("\x89PNG\0data", 9);
+    return record;
+}
+}
+
+TEST(slow_request_sampler_unittest, keep_slowest) {
+    auto prefix = test_prefix("keep");
+    {
+        SlowRequestSampler sampler(prefix, 3, 60000, 2);
+        for (int idx = 0; idx < 10; ++idx) {
+            sampler.offer(make_record("task_" + std::to_string(idx), (idx * 7) % 10));
+        }
+        // kept 9, 8, 7 ms
+        EXPECT_EQ(sampler.would_keep(6.5), false);
+        EXPECT_EQ(sampler.would_keep(7.5), true);
+        EXPECT_EQ(sampler.flush(), true);
+        EXPECT_EQ(sampler.written_windows(), 1);
+    }
+
+    std::vector<slow_request_record> records;
+    ASSERT_EQ(SlowRequestSampler::load(prefix + ".0.bin", records), true);
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0].total_ms, 9);
+    EXPECT_EQ(records[1].total_ms, 8);
+    EXPECT_EQ(records[2].total_ms, 7);
+    EXPECT_EQ(records[0].task_id, "task_7");
+    EXPECT_EQ(records[0].worker_id, 1);
+    ASSERT_EQ(records[0].stage_ms.size(), 1);
+    EXPECT_EQ(records[0].stage_ms[0].first, "model_run");
+    EXPECT_EQ(records[0].stage_ms[0].second, 4.5);
+    EXPECT_EQ(records[0].image_data, std::string("\x89PNG\0data", 9));
+    std::remove((prefix + ".0.bin").c_str());
+}
+
+TEST(slow_request_sampler_unittest, file_ring) {
+    auto prefix = test_prefix("ring");
+    {
+        SlowRequestSampler sampler(prefix, 2, 20, 2);
+        for (int window = 0; window < 3; ++window) {
+            sampler.offer(make_record("window_" + std::to_string(window), 10));
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        }
+        // third window is written by destructor
+    }
+
+    std::vector<slow_request_record> records;
+    ASSERT_EQ(SlowRequestSampler::load(prefix + ".0.bin", records), true);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].task_id, "window_2");
+    ASSERT_EQ(SlowRequestSampler::load(prefix + ".1.bin", records), true);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].task_id, "window_1");
+    std::ifstream tmp_file(prefix + ".0.bin.tmp");
+    EXPECT_EQ(tmp_file.is_open(), false);
+    std::remove((prefix + ".0.bin").c_str());
+    std::remove((prefix + ".1.bin").c_str());
+}
+
+TEST(slow_request_sampler_unittest, load_corrupted) {
+    auto path = test_prefix("corrupted") + ".0.bin";
+    std::vector<slow_request_record> records;
+    EXPECT_EQ(SlowRequestSampler::load(path, records), false);
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "MSLW\x01";
+    }
+    EXPECT_EQ(SlowRequestSampler::load(path, records), false);
+    EXPECT_EQ(records.empty(), true);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,89 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: socket_util_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "common/socket_util.h"
+
+using jinq::common::socket_util::is_local_peer;
+using jinq::common::socket_util::is_loopback_peer;
+using jinq::common::socket_util::is_peer_closed;
+
+namespace {
+
+/***
+ * connect a client to a loopback listener
+ * @param client_fd
+ * @param server_fd
+ * @return
+ */
+bool make_tcp_pair(int& client_fd, int& server_fd) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listen_fd, 1) != 0 || getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+        return false;
+    }
+    client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(client_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return false;
+    }
+    server_fd = accept(listen_fd, nullptr, nullptr);
+    close(listen_fd);
+    return server_fd >= 0;
+}
+}
+
+TEST(socket_util_unittest, peer_closed) {
+    int client_fd = -1;
+    int server_fd = -1;
+    ASSERT_EQ(make_tcp_pair(client_fd, server_fd), true);
+    EXPECT_EQ(is_peer_closed(server_fd), false);
+
+    // request bytes not read yet do not mean closed
+    ASSERT_EQ(write(client_fd, "GET", 3), 3);
+    usleep(10000);
+    EXPECT_EQ(is_peer_closed(server_fd), false);
+
+    close(client_fd);
+    usleep(10000);
+    EXPECT_EQ(is_peer_closed(server_fd), true);
+    close(server_fd);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    EXPECT_EQ(is_peer_closed(fds[0]), false);
+    close(fds[1]);
+    EXPECT_EQ(is_peer_closed(fds[0]), true);
+    close(fds[0]);
+    EXPECT_EQ(is_peer_closed(-1), false);
+}
+
+TEST(socket_util_unittest, peer_address) {
+    int client_fd = -1;
+    int server_fd = -1;
+    ASSERT_EQ(make_tcp_pair(client_fd, server_fd), true);
+    EXPECT_EQ(is_loopback_peer(server_fd), true);
+    EXPECT_EQ(is_local_peer(server_fd), false);
+    close(client_fd);
+    close(server_fd);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    EXPECT_EQ(is_local_peer(fds[0]), true);
+    EXPECT_EQ(is_loopback_peer(fds[0]), false);
+    close(fds[0]);
+    close(fds[1]);
+}
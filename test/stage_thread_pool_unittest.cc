@@ -0,0 +1,68 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: stage_thread_pool_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/stage_thread_pool.h"
+
+using jinq::common::StageThreadPool;
+
+TEST(stage_thread_pool_unittest, run_all_jobs) {
+    std::atomic<int> finished_jobs{0};
+    {
+        StageThreadPool pool(4);
+        EXPECT_EQ(pool.thread_nums(), 4);
+        for (int index = 0; index < 100; ++index) {
+            pool.submit([&finished_jobs]() { finished_jobs++; });
+        }
+    }
+    EXPECT_EQ(finished_jobs, 100);
+}
+
+TEST(stage_thread_pool_unittest, earliest_deadline_first) {
+    std::vector<int> run_order;
+    std::mutex order_mutex;
+    std::mutex block_mutex;
+    auto now = StageThreadPool::clock_type::now();
+    {
+        StageThreadPool pool(1);
+        // keep the only thread busy until all jobs are queued
+        block_mutex.lock();
+        pool.submit([&block_mutex]() { std::lock_guard<std::mutex> lock(block_mutex); });
+        while (pool.queued_nums() != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::vector<StageThreadPool::time_point> deadlines = {
+            StageThreadPool::time_point::max(), now + std::chrono::seconds(20),
+            now + std::chrono::seconds(10), StageThreadPool::time_point::max()
+        };
+        for (int index = 0; index < 4; ++index) {
+            pool.submit([&run_order, &order_mutex, index]() {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                run_order.push_back(index);
+            }, deadlines[index]);
+        }
+        block_mutex.unlock();
+    }
+
+    ASSERT_EQ(run_order.size(), 4);
+    EXPECT_EQ(run_order[0], 2);
+    EXPECT_EQ(run_order[1], 1);
+    EXPECT_EQ(run_order[2], 0);
+    EXPECT_EQ(run_order[3], 3);
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,50 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: token_bucket_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/token_bucket.h"
+
+using jinq::common::TokenBucket;
+
+TEST(token_bucket_unittest, burst) {
+    TokenBucket bucket(1.0, 3.0);
+    EXPECT_EQ(bucket.try_acquire(), true);
+    EXPECT_EQ(bucket.try_acquire(), true);
+    EXPECT_EQ(bucket.try_acquire(), true);
+
+    int64_t retry_after_ms = 0;
+    EXPECT_EQ(bucket.try_acquire(&retry_after_ms), false);
+    EXPECT_GT(retry_after_ms, 0);
+    EXPECT_LE(retry_after_ms, 1000);
+}
+
+TEST(token_bucket_unittest, refill) {
+    TokenBucket bucket(100.0, 1.0);
+    EXPECT_EQ(bucket.try_acquire(), true);
+    EXPECT_EQ(bucket.try_acquire(), false);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(bucket.try_acquire(), true);
+}
+
+TEST(token_bucket_unittest, acquire_many) {
+    TokenBucket bucket(10.0, 4.0);
+    EXPECT_EQ(bucket.try_acquire(nullptr, 3), true);
+    EXPECT_EQ(bucket.try_acquire(nullptr, 2), false);
+    EXPECT_EQ(bucket.try_acquire(), true);
+
+    // more than burst is granted to a full bucket and paid back by refills
+    TokenBucket large_bucket(10.0, 4.0);
+    EXPECT_EQ(large_bucket.try_acquire(nullptr, 8), true);
+    int64_t retry_after_ms = 0;
+    EXPECT_EQ(large_bucket.try_acquire(&retry_after_ms), false);
+    EXPECT_GT(retry_after_ms, 400);
+}
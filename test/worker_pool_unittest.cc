@@ -0,0 +1,237 @@
+/************************************************
+* Copyright MaybeShewill-CV. All Rights Reserved.
+* Author: MaybeShewill-CV
+* File: worker_pool_unittest.cc
+* Date: 26-10-16
+************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "server/worker_pool.h"
+
+using jinq::server::WorkerPool;
+
+TEST(worker_pool_unittest, dequeue_enqueue) {
+    WorkerPool<std::unique_ptr<int> > pool;
+    pool.enqueue(std::unique_ptr<int>(new int(1)));
+    pool.enqueue(std::unique_ptr<int>(new int(2)));
+    EXPECT_EQ(pool.size_approx(), 2);
+
+    std::unique_ptr<int> worker;
+    pool.dequeue(worker);
+    EXPECT_EQ(*worker, 1);
+    EXPECT_EQ(pool.try_dequeue(worker), true);
+    EXPECT_EQ(*worker, 2);
+    EXPECT_EQ(pool.try_dequeue(worker), false);
+}
+
+TEST(worker_pool_unittest, fifo_waiters) {
+    WorkerPool<int> pool;
+    std::vector<int> served_order;
+    std::mutex order_mutex;
+    std::vector<std::thread> waiters;
+
+    for (int index = 0; index < 4; ++index) {
+        waiters.emplace_back([&pool, &served_order, &order_mutex, index]() {
+            int worker = 0;
+            pool.dequeue(worker);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                served_order.push_back(index);
+            }
+            pool.enqueue(std::move(worker));
+        });
+        // make sure waiters are parked in index order
+        while (pool.waiting_nums() != static_cast<size_t>(index + 1)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    pool.enqueue(0);
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+
+    ASSERT_EQ(served_order.size(), 4);
+    for (int index = 0; index < 4; ++index) {
+        EXPECT_EQ(served_order[index], index);
+    }
+    EXPECT_EQ(pool.size_approx(), 1);
+    EXPECT_EQ(pool.waiting_nums(), 0);
+}
+
+TEST(worker_pool_unittest, earliest_deadline_first) {
+    WorkerPool<int> pool;
+    std::vector<int> served_order;
+    std::mutex order_mutex;
+    std::vector<std::thread> waiters;
+    auto now = WorkerPool<int>::clock_type::now();
+    // waiter 0 has no deadline, waiter 1 has the latest deadline, waiter 2 the earliest one
+    std::vector<WorkerPool<int>::time_point> deadlines = {
+        WorkerPool<int>::time_point::max(), now + std::chrono::seconds(20), now + std::chrono::seconds(10)
+    };
+
+    for (int index = 0; index < 3; ++index) {
+        auto deadline = deadlines[index];
+        waiters.emplace_back([&pool, &served_order, &order_mutex, index, deadline]() {
+            int worker = 0;
+            EXPECT_EQ(pool.dequeue(worker, deadline), true);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                served_order.push_back(index);
+            }
+            pool.enqueue(std::move(worker));
+        });
+        while (pool.waiting_nums() != static_cast<size_t>(index + 1)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    pool.enqueue(0);
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+
+    ASSERT_EQ(served_order.size(), 3);
+    EXPECT_EQ(served_order[0], 2);
+    EXPECT_EQ(served_order[1], 1);
+    EXPECT_EQ(served_order[2], 0);
+}
+
+TEST(worker_pool_unittest, deadline_expired) {
+    WorkerPool<int> pool;
+    int worker = 0;
+    auto now = WorkerPool<int>::clock_type::now();
+
+    // expired deadline never takes an idle worker
+    pool.enqueue(1);
+    EXPECT_EQ(pool.dequeue(worker, now - std::chrono::milliseconds(1)), false);
+    EXPECT_EQ(pool.size_approx(), 1);
+
+    // waiter gives up once deadline passed
+    EXPECT_EQ(pool.try_dequeue(worker), true);
+    EXPECT_EQ(pool.dequeue(worker, now + std::chrono::milliseconds(10)), false);
+    EXPECT_EQ(pool.waiting_nums(), 0);
+    pool.enqueue(std::move(worker));
+    EXPECT_EQ(pool.size_approx(), 1);
+}
+
+TEST(worker_pool_unittest, swap_workers) {
+    WorkerPool<std::unique_ptr<int> > pool;
+    pool.enqueue(std::unique_ptr<int>(new int(1)));
+    pool.enqueue(std::unique_ptr<int>(new int(2)));
+
+    // one old worker stays busy during swap
+    std::unique_ptr<int> busy_worker;
+    size_t busy_generation = 0;
+    pool.dequeue(busy_worker, busy_generation);
+    EXPECT_EQ(*busy_worker, 1);
+
+    std::vector<std::unique_ptr<int> > workers;
+    workers.emplace_back(new int(10));
+    workers.emplace_back(new int(20));
+    pool.swap_workers(workers);
+    ASSERT_EQ(workers.size(), 1);
+    EXPECT_EQ(*workers[0], 2);
+    EXPECT_EQ(pool.generation(), busy_generation + 1);
+
+    // busy old worker is dropped once it comes back
+    pool.enqueue(std::move(busy_worker), busy_generation);
+    EXPECT_EQ(pool.size_approx(), 2);
+
+    std::unique_ptr<int> worker;
+    size_t generation = 0;
+    pool.dequeue(worker, generation);
+    EXPECT_EQ(*worker, 10);
+    EXPECT_EQ(generation, pool.generation());
+    pool.enqueue(std::move(worker), generation);
+    EXPECT_EQ(pool.size_approx(), 2);
+}
+
+TEST(worker_pool_unittest, weighted_fair_tenants) {
+    WorkerPool<std::unique_ptr<int> > pool;
+    pool.configure_tenant(1, 3.0, 0);
+    pool.configure_tenant(2, 1.0, 0);
+    std::vector<size_t> served_tenants;
+    std::mutex order_mutex;
+    std::vector<std::thread> waiters;
+
+    // four waiters of each tenant, one worker is passed around among them
+    for (int index = 0; index < 8; ++index) {
+        size_t tenant = index < 4 ? 1 : 2;
+        waiters.emplace_back([&pool, &served_tenants, &order_mutex, tenant]() {
+            std::unique_ptr<int> worker;
+            size_t generation = 0;
+            pool.dequeue(worker, WorkerPool<std::unique_ptr<int> >::time_point::max(), &generation, tenant);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                served_tenants.push_back(tenant);
+            }
+            pool.enqueue(std::move(worker), generation, tenant);
+        });
+        while (pool.waiting_nums() != static_cast<size_t>(index + 1)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    pool.enqueue(std::unique_ptr<int>(new int(0)));
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+
+    // tenant 1 gets three workers for every one of tenant 2 while both are waiting
+    ASSERT_EQ(served_tenants.size(), 8);
+    EXPECT_EQ(std::count(served_tenants.begin(), served_tenants.begin() + 4, 1), 3);
+    EXPECT_EQ(pool.get_tenant_stat(1).served, 4);
+    EXPECT_EQ(pool.get_tenant_stat(2).served, 4);
+    EXPECT_EQ(pool.get_tenant_stat(1).running, 0);
+}
+
+TEST(worker_pool_unittest, tenant_max_concurrency) {
+    WorkerPool<std::unique_ptr<int> > pool;
+    pool.configure_tenant(1, 1.0, 1);
+    pool.enqueue(std::unique_ptr<int>(new int(1)));
+    pool.enqueue(std::unique_ptr<int>(new int(2)));
+
+    std::unique_ptr<int> busy_worker;
+    size_t busy_generation = 0;
+    EXPECT_EQ(pool.dequeue(busy_worker, WorkerPool<std::unique_ptr<int> >::time_point::max(), &busy_generation, 1), true);
+    EXPECT_EQ(pool.get_tenant_stat(1).running, 1);
+
+    // tenant at its limit waits although a worker is idle, other tenants are not blocked
+    std::unique_ptr<int> worker;
+    size_t generation = 0;
+    auto deadline = WorkerPool<std::unique_ptr<int> >::clock_type::now() + std::chrono::milliseconds(10);
+    EXPECT_EQ(pool.dequeue(worker, deadline, &generation, 1), false);
+    EXPECT_EQ(pool.size_approx(), 1);
+
+    std::thread waiter([&pool]() {
+        std::unique_ptr<int> worker;
+        size_t generation = 0;
+        pool.dequeue(worker, WorkerPool<std::unique_ptr<int> >::time_point::max(), &generation, 1);
+        pool.enqueue(std::move(worker), generation, 1);
+    });
+    while (pool.waiting_nums() != 1) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(pool.try_dequeue(worker), true);
+    pool.enqueue(std::move(worker));
+
+    // returned worker frees the slot for the waiter
+    pool.enqueue(std::move(busy_worker), busy_generation, 1);
+    waiter.join();
+    EXPECT_EQ(pool.get_tenant_stat(1).running, 0);
+    EXPECT_EQ(pool.get_tenant_stat(1).served, 2);
+    EXPECT_EQ(pool.size_approx(), 2);
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}